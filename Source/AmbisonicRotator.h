@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    AmbisonicRotator.h
+    First-order B-format (AmbiX: ACN W, Y, Z, X / SN3D) rotation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "cmath"
+
+namespace AmbisonicRotator
+{
+    //==============================================================================
+    /** 3x3 rotation of the (X, Y, Z) components with the directional gain folded in.
+        W only sees omniGain.
+    */
+    struct Matrix
+    {
+        double m[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+        double omniGain = 1.0;
+    };
+
+    /** Rz(yaw) * Ry(pitch) * Rx(roll), right-handed, angles in radians.
+        Positive yaw turns the scene to the left (counter-clockwise seen from above).
+    */
+    inline Matrix make(double yaw, double pitch, double roll, double omniGain, double directionalGain)
+    {
+        const double cy = std::cos(yaw), sy = std::sin(yaw);
+        const double cp = std::cos(pitch), sp = std::sin(pitch);
+        const double cr = std::cos(roll), sr = std::sin(roll);
+
+        Matrix r;
+        r.m[0][0] = cy * cp;  r.m[0][1] = cy * sp * sr - sy * cr;  r.m[0][2] = cy * sp * cr + sy * sr;
+        r.m[1][0] = sy * cp;  r.m[1][1] = sy * sp * sr + cy * cr;  r.m[1][2] = sy * sp * cr - cy * sr;
+        r.m[2][0] = -sp;      r.m[2][1] = cp * sr;                 r.m[2][2] = cp * cr;
+
+        for (auto& row : r.m)
+            for (auto& value : row)
+                value *= directionalGain;
+
+        r.omniGain = omniGain;
+        return r;
+    }
+
+    //==============================================================================
+    /** Rotates one block in place, interpolating every matrix entry linearly from
+        start to end. Channels are separate arrays, so each loop is a plain
+        multiply-add over samples the compiler can vectorize.
+    */
+    template <class sampleType>
+    inline void process(sampleType* w, sampleType* y, sampleType* z, sampleType* x, int numSamples,
+                        const Matrix& start, const Matrix& end)
+    {
+        if (numSamples <= 0) return;
+
+        const double step = 1.0 / numSamples;
+        double delta[3][3];
+        for (int row = 0; row < 3; ++row)
+            for (int column = 0; column < 3; ++column)
+                delta[row][column] = (end.m[row][column] - start.m[row][column]) * step;
+
+        const double omniDelta = (end.omniGain - start.omniGain) * step;
+
+        for (int i = 0; i < numSamples; ++i){
+            const double t = i + 1;
+            const double inX = x[i], inY = y[i], inZ = z[i];
+
+            w[i] = (sampleType)(w[i] * (start.omniGain + omniDelta * t));
+            x[i] = (sampleType)((start.m[0][0] + delta[0][0] * t) * inX + (start.m[0][1] + delta[0][1] * t) * inY + (start.m[0][2] + delta[0][2] * t) * inZ);
+            y[i] = (sampleType)((start.m[1][0] + delta[1][0] * t) * inX + (start.m[1][1] + delta[1][1] * t) * inY + (start.m[1][2] + delta[1][2] * t) * inZ);
+            z[i] = (sampleType)((start.m[2][0] + delta[2][0] * t) * inX + (start.m[2][1] + delta[2][1] * t) * inY + (start.m[2][2] + delta[2][2] * t) * inZ);
+        }
+    }
+}
@@ -0,0 +1,371 @@
+/*
+  ==============================================================================
+
+    BinauralRenderer.cpp
+    Headphone rendering of the stereo pair through an HRIR set.
+
+  ==============================================================================
+*/
+
+#include "BinauralRenderer.h"
+#include "cmath"
+#include "corecrt_math_defines.h"
+
+//==============================================================================
+/** Sums the tail partitions for the next block off the audio thread. */
+class BinauralRenderer::TailWorker  : public juce::Thread
+{
+public:
+    explicit TailWorker(BinauralRenderer& o)
+        : juce::Thread("LPanner HRIR tail"), owner(o)
+    {
+        startThread(7);
+    }
+
+    ~TailWorker() override
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread(1000);
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit()){
+            wait(-1);
+            if (threadShouldExit()) break;
+            owner.runWorkerJob();
+        }
+    }
+
+private:
+    BinauralRenderer& owner;
+};
+
+//==============================================================================
+std::shared_ptr<const BinauralRenderer::HRIRSet> BinauralRenderer::loadHRIR(const juce::File& file, double sampleRate, juce::String& error)
+{
+    //Longest response kept, in samples at the session rate
+    static constexpr int maxLength = 4096;
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr){
+        error = "Cannot read " + file.getFullPathName();
+        return nullptr;
+    }
+
+    const int numChannels = (int)reader->numChannels;
+    if (numChannels < 2 || numChannels % 2 != 0){
+        error = "HRIR file needs an even number of channels (left/right ear per azimuth)";
+        return nullptr;
+    }
+
+    const double ratio = reader->sampleRate / sampleRate;
+    const int fileLength = (int)juce::jmin<juce::int64>(reader->lengthInSamples, (juce::int64)std::ceil(maxLength * ratio));
+    if (fileLength <= 0){
+        error = "HRIR file is empty";
+        return nullptr;
+    }
+
+    //A few zeros of headroom for the interpolator
+    juce::AudioBuffer<float> raw(numChannels, fileLength + 8);
+    raw.clear();
+    reader->read(&raw, 0, fileLength, 0, true, true);
+
+    //Bring the responses to the session rate, keeping their gain
+    const int length = juce::jmin(maxLength, (int)std::ceil(fileLength / ratio));
+    juce::AudioBuffer<float> hrir(numChannels, length);
+    for (int channel = 0; channel < numChannels; ++channel){
+        if (std::abs(ratio - 1.0) < 1.0e-9){
+            hrir.copyFrom(channel, 0, raw, channel, 0, length);
+        }
+        else{
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, raw.getReadPointer(channel), hrir.getWritePointer(channel), length);
+            hrir.applyGain(channel, 0, length, (float)ratio);
+        }
+    }
+
+    std::shared_ptr<HRIRSet> newSet(new HRIRSet());
+    newSet->file = file;
+    newSet->sampleRate = sampleRate;
+    newSet->numAzimuths = numChannels / 2;
+    newSet->numPartitions = (length + partitionSize - 1) / partitionSize;
+    newSet->spectra.resize((size_t)newSet->numAzimuths * 2 * newSet->numPartitions * numBins);
+
+    //Each partition zero-padded to fftSize, as overlap-save expects
+    juce::dsp::FFT fft(fftOrder);
+    std::vector<float> fftBuffer((size_t)(2 * fftSize));
+
+    for (int azimuth = 0; azimuth < newSet->numAzimuths; ++azimuth){
+        for (int ear = 0; ear < 2; ++ear){
+            const float* response = hrir.getReadPointer(azimuth * 2 + ear);
+
+            for (int partition = 0; partition < newSet->numPartitions; ++partition){
+                const int start = partition * partitionSize;
+                const int num = juce::jmin(partitionSize, length - start);
+
+                juce::FloatVectorOperations::clear(fftBuffer.data(), 2 * fftSize);
+                juce::FloatVectorOperations::copy(fftBuffer.data(), response + start, num);
+                fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+                auto* spectrum = reinterpret_cast<Complex*>(fftBuffer.data());
+                std::copy(spectrum, spectrum + numBins, newSet->get(azimuth, ear, partition));
+            }
+        }
+    }
+
+    return newSet;
+}
+
+//==============================================================================
+BinauralRenderer::BinauralRenderer(std::shared_ptr<const HRIRSet> set)
+    : hrirSet(std::move(set))
+{
+    jassert(hrirSet != nullptr);
+
+    numSlots = hrirSet->numPartitions + maxBlocksAhead + 1;
+    inputSpectra.assign((size_t)numSlots * 2 * numBins, Complex());
+    workerTails.assign((size_t)(maxBlocksAhead + 1) * 2 * numBins, Complex());
+
+    //Only renderers with an HRIR set exist, so instances that never go binaural cost no thread
+    worker.reset(new TailWorker(*this));
+}
+
+BinauralRenderer::~BinauralRenderer()
+{
+    worker.reset();
+}
+
+void BinauralRenderer::reset()
+{
+    //Called from the audio thread too, so no lock. The job in flight is dropped first:
+    //its id no longer matches and its result is never used
+    activeSelection = Selection();
+    activeJob = 0;
+    activeCount = 0;
+
+    //inputSpectra is shared with the worker and left alone. Nothing reads a block
+    //below 0, and every block from 0 on is written by processPartition() before
+    //computeHead(), computeTail() or a new job reads it
+    juce::zeromem(inputFifo, sizeof(inputFifo));
+    juce::zeromem(outputFifo, sizeof(outputFifo));
+    juce::zeromem(inputHistory, sizeof(inputHistory));
+    fifoPosition = 0;
+    blockCounter = 0;
+    targetSelection = Selection();
+    currentSelection = Selection();
+}
+
+//==============================================================================
+void BinauralRenderer::setAzimuthOffset(double azimuthOffset)
+{
+    const int numAzimuths = hrirSet->numAzimuths;
+    auto indexFor = [numAzimuths](double degrees){
+        int index = juce::roundToInt(degrees / 360.0 * numAzimuths) % numAzimuths;
+        return index < 0 ? index + numAzimuths : index;
+    };
+
+    const double offset = juce::radiansToDegrees(azimuthOffset);
+    targetSelection.left = indexFor(30.0 + offset);
+    targetSelection.right = indexFor(-30.0 + offset);
+}
+
+BinauralRenderer::Complex* BinauralRenderer::getInputSpectrum(juce::int64 block, int speaker)
+{
+    return inputSpectra.data() + ((size_t)(block % numSlots) * 2 + speaker) * numBins;
+}
+
+const BinauralRenderer::Complex* BinauralRenderer::getInputSpectrum(juce::int64 block, int speaker) const
+{
+    return inputSpectra.data() + ((size_t)(block % numSlots) * 2 + speaker) * numBins;
+}
+
+void BinauralRenderer::computeHead(const Selection& selection, juce::int64 block, Complex* leftEar, Complex* rightEar) const
+{
+    const Complex* inputL = getInputSpectrum(block, 0);
+    const Complex* inputR = getInputSpectrum(block, 1);
+    const Complex* leftToLeft = hrirSet->get(selection.left, 0, 0);
+    const Complex* leftToRight = hrirSet->get(selection.left, 1, 0);
+    const Complex* rightToLeft = hrirSet->get(selection.right, 0, 0);
+    const Complex* rightToRight = hrirSet->get(selection.right, 1, 0);
+
+    for (int bin = 0; bin < numBins; ++bin){
+        leftEar[bin] = leftToLeft[bin] * inputL[bin] + rightToLeft[bin] * inputR[bin];
+        rightEar[bin] = leftToRight[bin] * inputL[bin] + rightToRight[bin] * inputR[bin];
+    }
+}
+
+void BinauralRenderer::computeTail(const Selection& selection, juce::int64 block, int firstPartition, int endPartition,
+                                   Complex* leftEar, Complex* rightEar) const
+{
+    //Partition p reads input block `block - p`, so partitions from n on only need input up to block - n
+    endPartition = juce::jmin(endPartition, hrirSet->numPartitions);
+    for (int partition = firstPartition; partition < endPartition && partition <= block; ++partition){
+        const Complex* inputL = getInputSpectrum(block - partition, 0);
+        const Complex* inputR = getInputSpectrum(block - partition, 1);
+        const Complex* leftToLeft = hrirSet->get(selection.left, 0, partition);
+        const Complex* leftToRight = hrirSet->get(selection.left, 1, partition);
+        const Complex* rightToLeft = hrirSet->get(selection.right, 0, partition);
+        const Complex* rightToRight = hrirSet->get(selection.right, 1, partition);
+
+        for (int bin = 0; bin < numBins; ++bin){
+            leftEar[bin] += leftToLeft[bin] * inputL[bin] + rightToLeft[bin] * inputR[bin];
+            rightEar[bin] += leftToRight[bin] * inputL[bin] + rightToRight[bin] * inputR[bin];
+        }
+    }
+}
+
+const BinauralRenderer::Complex* BinauralRenderer::getWorkerTail(const Selection& selection, juce::int64 block) const
+{
+    if (activeJob == 0 || readyJob.load(std::memory_order_acquire) != activeJob)
+        return nullptr;
+
+    const juce::int64 ahead = block - activeFirst;
+    if (selection == activeSelection && ahead >= 0 && ahead < activeCount)
+        return workerTails.data() + (size_t)ahead * 2 * numBins;
+    if (activeFade && selection == activeFadeFrom && ahead == 0)
+        return workerTails.data() + (size_t)maxBlocksAhead * 2 * numBins;
+
+    return nullptr;
+}
+
+void BinauralRenderer::renderSelection(const Selection& selection, juce::int64 block, float* leftOut, float* rightOut)
+{
+    computeHead(selection, block, accumulator[0], accumulator[1]);
+
+    if (const Complex* tail = getWorkerTail(selection, block)){
+        for (int bin = 0; bin < numBins; ++bin){
+            accumulator[0][bin] += tail[bin];
+            accumulator[1][bin] += tail[numBins + bin];
+        }
+
+        //The worker stopped at the input of the previous buffer; the partitions over
+        //this buffer's earlier blocks are added here
+        computeTail(selection, block, 1, (int)(block - activeFirst) + 1, accumulator[0], accumulator[1]);
+    }
+    else{
+        //Worker late, or a longer buffer than it was asked for
+        computeTail(selection, block, 1, hrirSet->numPartitions, accumulator[0], accumulator[1]);
+    }
+
+    float* outputs[2] = { leftOut, rightOut };
+    for (int ear = 0; ear < 2; ++ear){
+        auto* spectrum = reinterpret_cast<Complex*>(fftBuffer);
+        std::copy(accumulator[ear], accumulator[ear] + numBins, spectrum);
+        fft.performRealOnlyInverseTransform(fftBuffer);
+
+        //Overlap-save: the second half is the valid output
+        juce::FloatVectorOperations::copy(outputs[ear], fftBuffer + partitionSize, partitionSize);
+    }
+}
+
+void BinauralRenderer::processPartition()
+{
+    const juce::int64 block = blockCounter;
+
+    //Spectrum of the last two input partitions into the delay line
+    for (int speaker = 0; speaker < 2; ++speaker){
+        float* history = inputHistory[speaker];
+        juce::FloatVectorOperations::copy(history, history + partitionSize, partitionSize);
+        juce::FloatVectorOperations::copy(history + partitionSize, inputFifo[speaker], partitionSize);
+
+        juce::FloatVectorOperations::clear(fftBuffer, 2 * fftSize);
+        juce::FloatVectorOperations::copy(fftBuffer, history, fftSize);
+        fft.performRealOnlyForwardTransform(fftBuffer, true);
+
+        auto* spectrum = reinterpret_cast<Complex*>(fftBuffer);
+        std::copy(spectrum, spectrum + numBins, getInputSpectrum(block, speaker));
+    }
+
+    //Selections only change at the first block of a host buffer, as requested from the worker
+    const Selection previousSelection = currentSelection;
+    currentSelection = activeSelection;
+
+    renderSelection(currentSelection, block, renderScratch[0][0], renderScratch[0][1]);
+
+    if (previousSelection != currentSelection){
+        //Crossfade from the old filters over one partition
+        renderSelection(previousSelection, block, renderScratch[1][0], renderScratch[1][1]);
+
+        for (int ear = 0; ear < 2; ++ear){
+            for (int i = 0; i < partitionSize; ++i){
+                const float fade = (i + 1) / (float)partitionSize;
+                outputFifo[ear][i] = renderScratch[1][ear][i] + fade * (renderScratch[0][ear][i] - renderScratch[1][ear][i]);
+            }
+        }
+    }
+    else{
+        for (int ear = 0; ear < 2; ++ear)
+            juce::FloatVectorOperations::copy(outputFifo[ear], renderScratch[0][ear], partitionSize);
+    }
+
+    ++blockCounter;
+}
+
+void BinauralRenderer::requestTails(int numSamples)
+{
+    if (worker == nullptr) return;
+
+    //Partition blocks the next buffer completes if it is as long as this one
+    const int count = juce::jlimit(1, maxBlocksAhead, (fifoPosition + numSamples) / partitionSize);
+    const bool fade = targetSelection != currentSelection;
+
+    //Nothing new since the last request (short buffers that completed no block)
+    if (activeJob != 0 && activeFirst == blockCounter && activeCount == count
+     && activeSelection == targetSelection && activeFade == fade)
+        return;
+
+    activeFirst = blockCounter;
+    activeCount = count;
+    activeSelection = targetSelection;
+    activeFadeFrom = currentSelection;
+    activeFade = fade;
+    activeJob = ++jobCounter == 0 ? ++jobCounter : jobCounter;
+
+    requestedFirst.store(activeFirst, std::memory_order_relaxed);
+    requestedCount.store(count, std::memory_order_relaxed);
+    requestedLeft.store(activeSelection.left, std::memory_order_relaxed);
+    requestedRight.store(activeSelection.right, std::memory_order_relaxed);
+    requestedFadeLeft.store(fade ? activeFadeFrom.left : -1, std::memory_order_relaxed);
+    requestedFadeRight.store(fade ? activeFadeFrom.right : -1, std::memory_order_relaxed);
+    requestedJob.store(activeJob, std::memory_order_release);
+    worker->notify();
+}
+
+void BinauralRenderer::runWorkerJob()
+{
+    const juce::uint32 job = requestedJob.load(std::memory_order_acquire);
+    if (job == 0 || job == readyJob.load())
+        return;
+
+    const juce::int64 first = requestedFirst.load(std::memory_order_relaxed);
+    const int count = requestedCount.load(std::memory_order_relaxed);
+    Selection selection, fadeFrom;
+    selection.left = requestedLeft.load(std::memory_order_relaxed);
+    selection.right = requestedRight.load(std::memory_order_relaxed);
+    fadeFrom.left = requestedFadeLeft.load(std::memory_order_relaxed);
+    fadeFrom.right = requestedFadeRight.load(std::memory_order_relaxed);
+
+    //A newer request came in while reading; its notify runs this again
+    if (requestedJob.load(std::memory_order_acquire) != job)
+        return;
+
+    //Block first + n gets the partitions from n + 1 on, which only read input up to first - 1
+    for (int n = 0; n < count; ++n){
+        Complex* tail = getWorkerSlot(n);
+        std::fill(tail, tail + 2 * numBins, Complex());
+        computeTail(selection, first + n, n + 1, hrirSet->numPartitions, tail, tail + numBins);
+    }
+
+    if (fadeFrom.left >= 0){
+        Complex* tail = getWorkerSlot(maxBlocksAhead);
+        std::fill(tail, tail + 2 * numBins, Complex());
+        computeTail(fadeFrom, first, 1, hrirSet->numPartitions, tail, tail + numBins);
+    }
+
+    readyJob.store(job, std::memory_order_release);
+}
@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    BinauralRenderer.h
+    Headphone rendering of the stereo pair through an HRIR set.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include <vector>
+
+//==============================================================================
+/** Renders L/R as two virtual speakers at +-30 degrees plus a rotation offset,
+    using uniformly partitioned overlap-save FFT convolution.
+
+    HRIRs come from a WAV file holding 2 * K channels: channels 2k / 2k + 1 are the
+    left / right ear responses for azimuth k * 360 / K degrees, counter-clockwise
+    (90 degrees is left of the listener).
+
+    At the end of every host buffer a worker thread is asked for the tails of all
+    partition blocks of the next buffer (assumed to be the same size): for each it
+    sums the filter partitions whose input has already arrived. The audio thread
+    then only convolves the first partition plus the few that reach into the
+    current buffer; if the worker is late it does the whole tail inline. Azimuth
+    changes take effect at the next host buffer and crossfade between the old and
+    new filters over one partition, with the old filters' tail also from the worker.
+
+    A renderer is built for one HRIR set at one rate and never reloaded; a new set or
+    rate means a new renderer, so the owner can swap it in whole.
+*/
+class BinauralRenderer
+{
+public:
+    static constexpr int partitionSize = 64;
+
+private:
+    using Complex = std::complex<float>;
+    static constexpr int fftOrder = 7;
+    static constexpr int fftSize = 2 * partitionSize;
+    static constexpr int numBins = partitionSize + 1;
+
+public:
+    /** Filter spectra for every azimuth, ear and partition, at one sample rate.
+        Immutable once loaded, so renderers can share it. */
+    struct HRIRSet
+    {
+        juce::File file;
+        double sampleRate = 0.0;
+        int numAzimuths = 0;
+        int numPartitions = 0;
+        std::vector<Complex> spectra;
+
+        size_t getOffset(int azimuth, int ear, int partition) const
+        {
+            return (((size_t)azimuth * 2 + ear) * numPartitions + partition) * numBins;
+        }
+
+        const Complex* get(int azimuth, int ear, int partition) const { return spectra.data() + getOffset(azimuth, ear, partition); }
+        Complex* get(int azimuth, int ear, int partition)             { return spectra.data() + getOffset(azimuth, ear, partition); }
+    };
+
+    /** Reads an HRIR file and transforms it for the given rate. Not realtime safe.
+        Returns nullptr and sets error if the file is unusable. */
+    static std::shared_ptr<const HRIRSet> loadHRIR(const juce::File& file, double sampleRate, juce::String& error);
+
+    /** Allocates the delay line for set and starts the tail worker. Not realtime safe. */
+    explicit BinauralRenderer(std::shared_ptr<const HRIRSet> set);
+    ~BinauralRenderer();
+
+    const HRIRSet& getHRIRSet() const { return *hrirSet; }
+
+    /** Clears the convolution history. Realtime safe; the frequency-domain delay line
+        the worker reads is not touched, since no block is read before it is rewritten. */
+    void reset();
+
+    /** Added latency in samples. */
+    static int getLatencySamples() { return partitionSize; }
+
+    /** Renders an LR pair in place; azimuthOffset is in radians, positive to the left. */
+    template <class sampleType>
+    void process(sampleType* leftChannel, sampleType* rightChannel, int numSamples, double azimuthOffset)
+    {
+        setAzimuthOffset(azimuthOffset);
+
+        //Before the first request there is nothing to wait for, nor anything to fade from
+        if (activeJob == 0){
+            activeSelection = targetSelection;
+            if (blockCounter == 0)
+                currentSelection = targetSelection;
+        }
+
+        for (int i = 0; i < numSamples; ++i){
+            inputFifo[0][fifoPosition] = (float)leftChannel[i];
+            inputFifo[1][fifoPosition] = (float)rightChannel[i];
+            leftChannel[i] = (sampleType)outputFifo[0][fifoPosition];
+            rightChannel[i] = (sampleType)outputFifo[1][fifoPosition];
+
+            if (++fifoPosition == partitionSize){
+                processPartition();
+                fifoPosition = 0;
+            }
+        }
+
+        requestTails(numSamples);
+    }
+
+private:
+    /** HRIR index of the left and right virtual speaker. */
+    struct Selection
+    {
+        int left = 0, right = 0;
+        bool operator== (const Selection& other) const { return left == other.left && right == other.right; }
+        bool operator!= (const Selection& other) const { return !(*this == other); }
+    };
+
+    class TailWorker;
+
+    void setAzimuthOffset(double azimuthOffset);
+    void processPartition();
+    void computeHead(const Selection& selection, juce::int64 block, Complex* leftEar, Complex* rightEar) const;
+    void computeTail(const Selection& selection, juce::int64 block, int firstPartition, int endPartition, Complex* leftEar, Complex* rightEar) const;
+    const Complex* getWorkerTail(const Selection& selection, juce::int64 block) const;
+    Complex* getWorkerSlot(int slot) { return workerTails.data() + (size_t)slot * 2 * numBins; }
+    void requestTails(int numSamples);
+    void renderSelection(const Selection& selection, juce::int64 block, float* leftOut, float* rightOut);
+    Complex* getInputSpectrum(juce::int64 block, int speaker);
+    const Complex* getInputSpectrum(juce::int64 block, int speaker) const;
+
+    juce::dsp::FFT fft { fftOrder };
+    const std::shared_ptr<const HRIRSet> hrirSet;
+
+    //Partition blocks of one host buffer the worker prepares; longer buffers do the rest inline
+    static constexpr int maxBlocksAhead = 32;
+
+    //Frequency-domain delay line; spare slots for a buffer ahead, so a worker that is still
+    //reading never sees a slot overwritten before its result stops being usable
+    int numSlots = 0;
+    std::vector<Complex> inputSpectra;
+    juce::int64 blockCounter = 0;
+
+    float inputFifo[2][partitionSize] = {};
+    float outputFifo[2][partitionSize] = {};
+    int fifoPosition = 0;
+
+    float inputHistory[2][fftSize] = {};
+    float fftBuffer[2 * fftSize] = {};
+    Complex accumulator[2][numBins];
+    float renderScratch[2][2][partitionSize] = {};
+
+    Selection targetSelection, currentSelection;
+
+    //Audio thread: what the last request asked for. Job ids are never reused, and
+    //reset() clears activeJob, so a result still in flight from before is ignored
+    Selection activeSelection, activeFadeFrom;
+    juce::int64 activeFirst = 0;
+    int activeCount = 0;
+    bool activeFade = false;
+    juce::uint32 activeJob = 0, jobCounter = 0;
+
+    //Request, published by requestedJob; the worker re-reads the id to catch a newer one
+    std::atomic<juce::int64> requestedFirst { 0 };
+    std::atomic<int> requestedCount { 0 }, requestedLeft { 0 }, requestedRight { 0 };
+    std::atomic<int> requestedFadeLeft { -1 }, requestedFadeRight { -1 };
+    std::atomic<juce::uint32> requestedJob { 0 }, readyJob { 0 };
+
+    //Written by the worker, read by the audio thread once readyJob == activeJob:
+    //one tail per requested block, the fade tail in slot maxBlocksAhead
+    std::vector<Complex> workerTails;
+    std::unique_ptr<TailWorker> worker;
+
+    void runWorkerJob();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BinauralRenderer)
+};
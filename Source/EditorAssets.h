@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+    EditorAssets.h
+    Images and fonts shared by every open LPanner editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BinaryData.h"
+
+//==============================================================================
+/** Decoded once per process and shared through juce::SharedResourcePointer,
+    so opening another editor never touches the PNG decoder again.
+*/
+struct EditorAssets
+{
+    EditorAssets()
+        : powerOn(juce::ImageFileFormat::loadFrom(BinaryData::powerOn_png, BinaryData::powerOn_pngSize)),
+          powerOff(juce::ImageFileFormat::loadFrom(BinaryData::powerOff_png, BinaryData::powerOff_pngSize)),
+          titleFont(30.0f, juce::Font::bold),
+          sectionFont(16.0f, juce::Font::bold)
+    {
+    }
+
+    const juce::Image powerOn, powerOff;
+    const juce::Font titleFont, sectionFont;
+
+    JUCE_DECLARE_NON_COPYABLE(EditorAssets)
+};
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    OutputMeter.h
+    Output level and correlation display for the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "RefreshScheduler.h"
+
+//==============================================================================
+/** Peak/RMS bar and correlation bar fed by StereoPanAudioProcessor::getOutputLevels().
+    The processor measures inside its matrix pass, so stereo levels are before LPF-Link
+    (the editor labels it); this only reads the published values, and the shared
+    RefreshScheduler repaints it when a new block has arrived.
+*/
+class OutputMeter  : public juce::Component,
+                     private RefreshScheduler::Client
+{
+public:
+    explicit OutputMeter(StereoPanAudioProcessor& p)
+        : processor(p)
+    {
+        setOpaque(true);
+        scheduler->addClient(this);
+    }
+
+    ~OutputMeter() override
+    {
+        scheduler->removeClient(this);
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        auto bounds = getLocalBounds().toFloat();
+        g.fillAll(juce::Colours::black);
+
+        auto levelArea = bounds.removeFromTop(bounds.getHeight() / 2).reduced(1.0f);
+        auto correlationArea = bounds.reduced(1.0f);
+
+        //Level: RMS filled, peak as a line, -60..+6 dB
+        auto toX = [&levelArea](float gain){
+            float db = juce::jlimit(minDecibels, maxDecibels, juce::Decibels::gainToDecibels(gain, minDecibels));
+            return levelArea.getX() + levelArea.getWidth() * (db - minDecibels) / (maxDecibels - minDecibels);
+        };
+
+        g.setColour(juce::Colours::seagreen);
+        g.fillRect(levelArea.withRight(toX(rms)));
+        g.setColour(peak > 1.0f ? juce::Colours::red : juce::Colours::lightgreen);
+        g.fillRect(juce::Rectangle<float>(toX(peak) - 1.0f, levelArea.getY(), 2.0f, levelArea.getHeight()));
+
+        //Correlation: -1 (left edge) to +1 (right edge), bar grows from the centre
+        float centre = correlationArea.getCentreX();
+        float x = centre + correlation * correlationArea.getWidth() / 2;
+        g.setColour(correlation < 0.0f ? juce::Colours::orange : juce::Colours::skyblue);
+        g.fillRect(juce::Rectangle<float>(juce::jmin(centre, x), correlationArea.getY(), std::abs(x - centre), correlationArea.getHeight()));
+        g.setColour(juce::Colours::grey);
+        g.drawVerticalLine(juce::roundToInt(centre), correlationArea.getY(), correlationArea.getBottom());
+    }
+
+private:
+    juce::Component& getRefreshComponent() override { return *this; }
+
+    bool updateForRefresh() override
+    {
+        auto levels = processor.getOutputLevels();
+        if (levels.block == lastBlock) return false;
+        lastBlock = levels.block;
+
+        //Peak falls back gradually, the rest follows the published values
+        peak = juce::jmax(levels.peak, peak * peakDecay);
+        rms = levels.rms;
+        correlation = levels.correlation;
+        return true;
+    }
+
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float maxDecibels = 6.0f;
+    static constexpr float peakDecay = 0.93f;   //Per refresh frame
+
+    StereoPanAudioProcessor& processor;
+    juce::SharedResourcePointer<RefreshScheduler> scheduler;
+    juce::uint32 lastBlock = 0;
+    float peak = 0.0f, rms = 0.0f, correlation = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutputMeter)
+};
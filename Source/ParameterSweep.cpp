@@ -0,0 +1,187 @@
+/*
+  ==============================================================================
+
+    ParameterSweep.cpp
+    Offline rendering of one input through many LPanner settings at once.
+
+  ==============================================================================
+*/
+
+#include "ParameterSweep.h"
+#include "cmath"
+#include "corecrt_math_defines.h"
+
+namespace ParameterSweep
+{
+//==============================================================================
+std::vector<Setting> parseSettings(const juce::var& json)
+{
+    std::vector<Setting> settings;
+    if (!json.isArray()) return settings;
+
+    for (const auto& entry : *json.getArray()){
+        Setting setting;
+        setting.name = entry.getProperty("name", "setting" + juce::String((int)settings.size() + 1)).toString();
+        setting.gain = (float)entry.getProperty("gain", setting.gain);
+        setting.width = (float)entry.getProperty("width", setting.width);
+        setting.rotation = (float)entry.getProperty("rotation", setting.rotation);
+        setting.lpfFreq = (float)entry.getProperty("lpffreq", setting.lpfFreq);
+        setting.widthBypass = (bool)entry.getProperty("widthbypass", setting.widthBypass);
+        setting.rotationBypass = (bool)entry.getProperty("rotationbypass", setting.rotationBypass);
+        setting.lpfLink = (bool)entry.getProperty("lpflink", setting.lpfLink);
+        settings.push_back(setting);
+    }
+
+    return settings;
+}
+
+//==============================================================================
+LaneGroup::LaneGroup(const Setting* settings, int num, double sampleRate)
+    : numSettings(juce::jmin(num, (int)numLanes))
+{
+    for (int lane = 0; lane < numLanes; ++lane){
+        //Spare lanes repeat the first setting; their output is dropped
+        const Setting& s = settings[lane < numSettings ? lane : 0];
+
+        //Same angles as processBlockWrapper
+        double Theta_w = s.widthBypass ? 0.0 : M_PI / 200 * ((double)s.width - 50);
+        double Theta_r = s.rotationBypass ? 0.0 : -M_PI / 400 * s.rotation;
+
+        auto c = StereoMatrix::make(Theta_w, Theta_r, std::pow(s.gain, 2));
+        midToMid[lane] = c.midToMid;
+        sideToMid[lane] = c.sideToMid;
+        midToSide[lane] = c.midToSide;
+        sideToSide[lane] = c.sideToSide;
+
+        const int lpfSide = s.lpfLink ? StereoMatrix::getLowPassLinkSide(Theta_r) : 0;
+        if (lpfSide != 0){
+            double coefficients[5];
+            StereoMatrix::makeLowPass(sampleRate, StereoMatrix::getLowPassLinkFrequency(Theta_r, s.lpfFreq), 0.7, coefficients);
+            b0[lane] = coefficients[0];
+            b1[lane] = coefficients[1];
+            b2[lane] = coefficients[2];
+            a1[lane] = coefficients[3];
+            a2[lane] = coefficients[4];
+        }
+        else{
+            b0[lane] = 1.0;
+        }
+        filterRight[lane] = lpfSide > 0 ? 1.0 : 0.0;
+    }
+}
+
+void LaneGroup::process(const float* left, const float* right, int numSamples, float* const* outLeft, float* const* outRight)
+{
+    for (int i = 0; i < numSamples; ++i){
+        //Input decoded once, shared by every lane
+        const double midInput = (double)left[i] + right[i];
+        const double sideInput = (double)left[i] - right[i];
+
+        double outL[numLanes], outR[numLanes];
+
+        for (int lane = 0; lane < numLanes; ++lane){
+            const double midRotation = midToMid[lane] * midInput + sideToMid[lane] * sideInput;
+            const double sideRotation = midToSide[lane] * midInput + sideToSide[lane] * sideInput;
+            const double l = midRotation + sideRotation;
+            const double r = midRotation - sideRotation;
+
+            //Branch-free LPFLink: pick the side by weight, transposed direct form II
+            const double x = l + filterRight[lane] * (r - l);
+            const double y = b0[lane] * x + s1[lane];
+            s1[lane] = b1[lane] * x - a1[lane] * y + s2[lane];
+            s2[lane] = b2[lane] * x - a2[lane] * y;
+
+            outL[lane] = l + (1.0 - filterRight[lane]) * (y - l);
+            outR[lane] = r + filterRight[lane] * (y - r);
+        }
+
+        for (int lane = 0; lane < numSettings; ++lane){
+            outLeft[lane][i] = (float)outL[lane];
+            outRight[lane][i] = (float)outR[lane];
+        }
+    }
+}
+
+//==============================================================================
+juce::String render(const juce::File& input, const std::vector<Setting>& settings,
+                    const juce::File& outputFolder, int blockSize)
+{
+    if (settings.empty())
+        return "No settings to render";
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+    if (reader == nullptr)
+        return "Cannot read " + input.getFullPathName();
+
+    if (!outputFolder.createDirectory())
+        return "Cannot create " + outputFolder.getFullPathName();
+
+    const int numSettings = (int)settings.size();
+    const int bitDepth = juce::jlimit(16, 24, (int)reader->bitsPerSample);
+
+    //One writer per setting; names that clash (also after cleaning, and ignoring case)
+    //get the setting's number appended so no writer reopens another's file
+    juce::WavAudioFormat wavFormat;
+    std::vector<std::unique_ptr<juce::AudioFormatWriter>> writers;
+    juce::StringArray usedNames;
+    for (int index = 0; index < numSettings; ++index){
+        juce::String fileName = juce::File::createLegalFileName(settings[(size_t)index].name);
+        for (int suffix = index + 1; usedNames.contains(fileName, true); ++suffix)
+            fileName = juce::File::createLegalFileName(settings[(size_t)index].name) + "-" + juce::String(suffix);
+        usedNames.add(fileName);
+
+        auto file = outputFolder.getChildFile(fileName + ".wav");
+        file.deleteFile();
+
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+        if (stream == nullptr)
+            return "Cannot write " + file.getFullPathName();
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), reader->sampleRate, 2, bitDepth, {}, 0));
+        if (writer == nullptr)
+            return "Cannot write " + file.getFullPathName();
+
+        stream.release();   //Owned by the writer now
+        writers.push_back(std::move(writer));
+    }
+
+    std::vector<LaneGroup> groups;
+    for (int first = 0; first < numSettings; first += LaneGroup::numLanes)
+        groups.emplace_back(settings.data() + first, numSettings - first, reader->sampleRate);
+
+    //Memory is one input chunk plus one output chunk per setting, whatever the file length
+    juce::AudioBuffer<float> inputBlock(2, blockSize);
+    juce::AudioBuffer<float> outputBlock(2 * numSettings, blockSize);
+
+    for (juce::int64 position = 0; position < reader->lengthInSamples; ){
+        const int num = (int)juce::jmin<juce::int64>(blockSize, reader->lengthInSamples - position);
+        if (!reader->read(&inputBlock, 0, num, position, true, true))
+            return "Read error in " + input.getFullPathName();
+
+        for (size_t group = 0; group < groups.size(); ++group){
+            float* outLeft[LaneGroup::numLanes];
+            float* outRight[LaneGroup::numLanes];
+            for (int lane = 0; lane < groups[group].getNumSettings(); ++lane){
+                const int setting = (int)group * LaneGroup::numLanes + lane;
+                outLeft[lane] = outputBlock.getWritePointer(2 * setting);
+                outRight[lane] = outputBlock.getWritePointer(2 * setting + 1);
+            }
+
+            groups[group].process(inputBlock.getReadPointer(0), inputBlock.getReadPointer(1), num, outLeft, outRight);
+        }
+
+        for (int setting = 0; setting < numSettings; ++setting){
+            const float* channels[] = { outputBlock.getReadPointer(2 * setting), outputBlock.getReadPointer(2 * setting + 1), nullptr };
+            if (!writers[(size_t)setting]->writeFromFloatArrays(channels, 2, num))
+                return "Write error for " + settings[(size_t)setting].name;
+        }
+
+        position += num;
+    }
+
+    return {};
+}
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    ParameterSweep.h
+    Offline rendering of one input through many LPanner settings at once.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "StereoMatrix.h"
+
+namespace ParameterSweep
+{
+    //==============================================================================
+    /** One static LPanner setting, in parameter units. */
+    struct Setting
+    {
+        juce::String name;
+        float gain = 0.7f;
+        float width = 50.0f;
+        float rotation = 0.0f;
+        float lpfFreq = 20000.0f;
+        bool widthBypass = false;
+        bool rotationBypass = false;
+        bool lpfLink = false;
+    };
+
+    /** Reads settings from an array of objects keyed like the plugin parameters
+        ("name", "gain", "width", "rotation", "lpffreq", "widthbypass", "rotationbypass", "lpflink").
+        Missing keys keep their defaults. */
+    std::vector<Setting> parseSettings(const juce::var& json);
+
+    //==============================================================================
+    /** Renders a group of up to numLanes settings over a shared, read-only LR input.
+        Settings are laid out as lanes: every per-setting quantity is an array indexed
+        by lane, so the inner loop over lanes has no dependency between iterations and
+        vectorizes, LPFLink biquads included. Processing matches the Standard quality
+        path with settled parameters.
+    */
+    class LaneGroup
+    {
+    public:
+        static constexpr int numLanes = 4;  //One AVX register of doubles
+
+        LaneGroup(const Setting* settings, int numSettings, double sampleRate);
+
+        int getNumSettings() const { return numSettings; }
+
+        /** Reads numSamples from left / right and writes one LR pair per setting. */
+        void process(const float* left, const float* right, int numSamples, float* const* outLeft, float* const* outRight);
+
+    private:
+        int numSettings = 0;
+
+        //Matrix, per lane
+        double midToMid[numLanes] = {}, sideToMid[numLanes] = {}, midToSide[numLanes] = {}, sideToSide[numLanes] = {};
+
+        //LPFLink biquad, per lane; lanes without LPFLink run an identity filter
+        double b0[numLanes] = {}, b1[numLanes] = {}, b2[numLanes] = {}, a1[numLanes] = {}, a2[numLanes] = {};
+        double s1[numLanes] = {}, s2[numLanes] = {};
+        double filterRight[numLanes] = {};  //1 filters R, 0 filters L
+    };
+
+    //==============================================================================
+    /** Decodes input once and writes <name>.wav into outputFolder for every setting,
+        streaming in blockSize chunks. A name already taken gets "-<number>" appended.
+        Blocks until done; returns an error or an empty string. */
+    juce::String render(const juce::File& input, const std::vector<Setting>& settings,
+                        const juce::File& outputFolder, int blockSize = 8192);
+}
@@ -14,22 +14,28 @@
 StereoPanAudioProcessorEditor::StereoPanAudioProcessorEditor (StereoPanAudioProcessor& p, juce::AudioProcessorValueTreeState & vts)
     : AudioProcessorEditor (&p), valueTreeState(vts), audioProcessor(p)
 {
+    setOpaque(true);
+
     addAndMakeVisible(mainTitle);
     mainTitle.setText("LPanner", juce::dontSendNotification);
-    mainTitle.setFont(juce::Font(30.0f, juce::Font::bold));
+    mainTitle.setFont(assets->titleFont);
     //mainTitle.setJustificationType(juce::Justification::centred);
 
     addAndMakeVisible(bypassButton);
     bypassButton.setImages(false, true, true,
-        juce::ImageCache::getFromMemory(BinaryData::powerOn_png, BinaryData::powerOn_pngSize), 1.0f, juce::Colour::Colour(0.f, 0.f, 0.f, 0.f),
-        juce::ImageCache::getFromMemory(BinaryData::powerOn_png, BinaryData::powerOn_pngSize), 1.0f, juce::Colour::Colour(0.f, 0.f, 0.f, 0.f),
-        juce::ImageCache::getFromMemory(BinaryData::powerOff_png, BinaryData::powerOff_pngSize), 1.0f, juce::Colour::Colour(0.f, 0.f, 0.f, 0.f));
+        assets->powerOn, 1.0f, juce::Colour::Colour(0.f, 0.f, 0.f, 0.f),
+        assets->powerOn, 1.0f, juce::Colour::Colour(0.f, 0.f, 0.f, 0.f),
+        assets->powerOff, 1.0f, juce::Colour::Colour(0.f, 0.f, 0.f, 0.f));
     bypassButton.setClickingTogglesState(true);
     bypassAttachment.reset(new ButtonAttachment(valueTreeState, "masterbypass", bypassButton));
 
+    addAndMakeVisible(qualityBox);
+    qualityBox.addItemList(juce::StringArray("Eco", "Standard", "High"), 1);
+    qualityAttachment.reset(new ComboBoxAttachment(valueTreeState, "quality", qualityBox));
+
     addAndMakeVisible(gainTitle);
     gainTitle.setText("Gain", juce::dontSendNotification);
-    gainTitle.setFont(juce::Font(16.0f, juce::Font::bold));
+    gainTitle.setFont(assets->sectionFont);
     gainTitle.setJustificationType(juce::Justification::centred);
 
     addAndMakeVisible(gainSlider);
@@ -42,7 +48,7 @@ StereoPanAudioProcessorEditor::StereoPanAudioProcessorEditor (StereoPanAudioProc
 
     addAndMakeVisible(widthTitle);
     widthTitle.setText("Width", juce::dontSendNotification);
-    widthTitle.setFont(juce::Font(16.0f, juce::Font::bold));
+    widthTitle.setFont(assets->sectionFont);
     widthTitle.setJustificationType(juce::Justification::centred);
 
     addAndMakeVisible(widthSlider);
@@ -55,7 +61,7 @@ StereoPanAudioProcessorEditor::StereoPanAudioProcessorEditor (StereoPanAudioProc
 
     addAndMakeVisible(rotationTitle);
     rotationTitle.setText("Rotation", juce::dontSendNotification);
-    rotationTitle.setFont(juce::Font(16.0f, juce::Font::bold));
+    rotationTitle.setFont(assets->sectionFont);
     rotationTitle.setJustificationType(juce::Justification::centred);
 
     addAndMakeVisible(rotationSlider);
@@ -65,7 +71,7 @@ StereoPanAudioProcessorEditor::StereoPanAudioProcessorEditor (StereoPanAudioProc
 
     addAndMakeVisible(lpfTitle);
     lpfTitle.setText("LPF", juce::dontSendNotification);
-    lpfTitle.setFont(juce::Font(16.0f, juce::Font::bold));
+    lpfTitle.setFont(assets->sectionFont);
     lpfTitle.setJustificationType(juce::Justification::centred);
 
     addAndMakeVisible(lpfFreqSlider);
@@ -77,13 +83,146 @@ StereoPanAudioProcessorEditor::StereoPanAudioProcessorEditor (StereoPanAudioProc
     lpfLinkButton.setClickingTogglesState(true);
     lpfLinkAttachment.reset(new ButtonAttachment(valueTreeState, "lpflink", lpfLinkButton));
 
-    setSize (260,580);
+    addAndMakeVisible(binauralButton);
+    binauralAttachment.reset(new ButtonAttachment(valueTreeState, "binaural", binauralButton));
+
+    addAndMakeVisible(hrirButton);
+    hrirButton.setTooltip(audioProcessor.getHRIRFile().getFileName());
+    hrirButton.onClick = [this](){
+        hrirChooser.reset(new juce::FileChooser("Load HRIR", audioProcessor.getHRIRFile(), "*.wav"));
+        hrirChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser& chooser){
+                auto file = chooser.getResult();
+                if (file == juce::File()) return;
+
+                auto error = audioProcessor.loadHRIR(file);
+                if (error.isNotEmpty())
+                    juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "LPanner", error);
+
+                hrirButton.setTooltip(audioProcessor.getHRIRFile().getFileName());
+            });
+    };
+
+    addAndMakeVisible(auditButton);
+    auditButton.setTooltip("Write a stereo-field report for every audio file in a folder");
+    auditButton.onClick = [this](){
+        auditChooser.reset(new juce::FileChooser("Audit folder", juce::File::getSpecialLocation(juce::File::userMusicDirectory)));
+        auditChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories,
+            [this](const juce::FileChooser& chooser){
+                auto folder = chooser.getResult();
+                if (!folder.isDirectory()) return;
+
+                //The report may arrive after this editor is gone, so no captures of it
+                bool started = audioProcessor.startAudit(folder, [](const juce::String& summary){
+                    juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::InfoIcon, "LPanner", summary);
+                });
+                if (!started)
+                    juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "LPanner", "An audit is already running");
+            });
+    };
+
+    //Stereo paths meter the matrix output, before LPF-Link and the High downsampling
+    addAndMakeVisible(meterTitle);
+    meterTitle.setText("Pre-LPF", juce::dontSendNotification);
+    meterTitle.setJustificationType(juce::Justification::centredLeft);
+
+    addAndMakeVisible(outputMeter);
+
+    addAndMakeVisible(presetLibraryButton);
+    presetLibraryButton.onClick = [this](){
+        auto library = audioProcessor.getPresetLibrary();
+        presetLibraryChooser.reset(new juce::FileChooser("Open preset library", library != nullptr ? library->getFile() : juce::File(), "*.lpp"));
+        presetLibraryChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser& chooser){
+                auto file = chooser.getResult();
+                if (file == juce::File()) return;
+
+                auto error = audioProcessor.loadPresetLibrary(file);
+                if (error.isNotEmpty())
+                    juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "LPanner", error);
+
+                updatePresetBox();
+            });
+    };
+
+    addAndMakeVisible(presetBox);
+    presetBox.setTextWhenNothingSelected("No preset");
+    presetBox.setTextWhenNoChoicesAvailable("No library");
+    presetBox.onChange = [this](){
+        if (presetBox.getSelectedId() > 0)
+            audioProcessor.applyPreset(presetBox.getSelectedId() - 1);
+    };
+
+    //Large libraries are narrowed by name instead of scrolled through
+    addAndMakeVisible(presetSearch);
+    presetSearch.setTextToShowWhenEmpty("Search presets", juce::Colours::grey);
+    presetSearch.onTextChange = [this](){ updatePresetBox(); };
+    presetSearch.onEscapeKey = [this](){ presetSearch.clear(); updatePresetBox(); };
+
+    updatePresetBox();
+
+    //Host-driven resizing; children keep their layout and are scaled as a whole
+    setResizable(true, false);
+    setResizeLimits(baseWidth / 2, baseHeight / 2, baseWidth * 2, baseHeight * 2);
+    getConstrainer()->setFixedAspectRatio((double)baseWidth / baseHeight);
+
+    setSize (baseWidth, baseHeight);
 }
 
 StereoPanAudioProcessorEditor::~StereoPanAudioProcessorEditor()
 {
 }
 
+void StereoPanAudioProcessorEditor::updatePresetBox()
+{
+    presetBox.clear(juce::dontSendNotification);
+
+    auto library = audioProcessor.getPresetLibrary();
+    if (library == nullptr) return;
+
+    //A search lists its matches in library order, as many as the menu holds
+    const auto text = presetSearch.getText().trim();
+    if (text.isNotEmpty()){
+        const auto matches = library->search(text);
+        for (int n = 0; n < juce::jmin(matches.size(), (int)maxListedPresets); ++n)
+            presetBox.addItem(library->getName(matches[n]), matches[n] + 1);
+
+        if (matches.isEmpty())
+            presetBox.addSectionHeading("No match for \"" + text + "\"");
+        else if (matches.size() > maxListedPresets)
+            presetBox.addSectionHeading(juce::String(matches.size() - maxListedPresets) + " more, refine the search");
+        return;
+    }
+
+    //Each preset is listed once, under the first of its tags; item ID is the preset index + 1
+    std::vector<bool> listed((size_t)library->getNumPresets(), false);
+    int numListed = 0;
+    for (int tag = 0; tag < library->getNumTags() && numListed < maxListedPresets; ++tag){
+        presetBox.addSectionHeading(library->getTagName(tag));
+        for (int n = 0; n < library->getNumPresetsWithTag(tag) && numListed < maxListedPresets; ++n){
+            int preset = library->getPresetWithTag(tag, n);
+            if (listed[(size_t)preset]) continue;
+            listed[(size_t)preset] = true;
+            presetBox.addItem(library->getName(preset), preset + 1);
+            ++numListed;
+        }
+    }
+
+    bool headingAdded = false;
+    for (int preset = 0; preset < library->getNumPresets() && numListed < maxListedPresets; ++preset){
+        if (listed[(size_t)preset]) continue;
+        if (!headingAdded && library->getNumTags() > 0){
+            presetBox.addSectionHeading("Other");
+            headingAdded = true;
+        }
+        presetBox.addItem(library->getName(preset), preset + 1);
+        ++numListed;
+    }
+
+    if (numListed < library->getNumPresets())
+        presetBox.addSectionHeading(juce::String(library->getNumPresets() - numListed) + " more, search to find them");
+}
+
 //==============================================================================
 void StereoPanAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -100,6 +239,7 @@ void StereoPanAudioProcessorEditor::resized()
 
     mainTitle.setBounds(10, 5, 140, 40);
     bypassButton.setBounds(140, 15, 25, 25);
+    qualityBox.setBounds(175, 15, 80, 25);
 
     widthTitle.setBounds(35, 75, 80, 80);
     widthSlider.setBounds(0, 60, knobSide, knobSide);
@@ -112,6 +252,23 @@ void StereoPanAudioProcessorEditor::resized()
 
     lpfLinkButton.setBounds(0, 418, 25, 25);
 
+    binauralButton.setBounds(5, 470, 100, 25);
+    hrirButton.setBounds(5, 500, 90, 25);
+    auditButton.setBounds(5, 530, 90, 25);
+
     gainTitle.setBounds(145, 435, 80, 80);
     gainSlider.setBounds(110, 420, knobSide, knobSide);
+
+    meterTitle.setBounds(5, 585, 55, 30);
+    outputMeter.setBounds(60, 585, 195, 30);
+
+    presetLibraryButton.setBounds(5, 620, 70, 25);
+    presetBox.setBounds(80, 620, 175, 25);
+    presetSearch.setBounds(5, 650, 250, 25);
+
+    //Everything above is laid out at the base size, so scaling is just a transform
+    //and the shared images are resampled instead of decoded again
+    auto transform = juce::AffineTransform::scale(getWidth() / (float)baseWidth);
+    for (auto* child : getChildren())
+        child->setTransform(transform);
 }
@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "EditorAssets.h"
+#include "OutputMeter.h"
 
 //==============================================================================
 /**
@@ -36,11 +38,19 @@ private:
 
     juce::AudioProcessorValueTreeState& valueTreeState;
 
+    juce::SharedResourcePointer<EditorAssets> assets;
+
+    static constexpr int baseWidth = 260;
+    static constexpr int baseHeight = 680;
+
     juce::Label mainTitle;
 
     juce::ImageButton bypassButton;
     std::unique_ptr<ButtonAttachment> bypassAttachment;
 
+    juce::ComboBox qualityBox;
+    std::unique_ptr<ComboBoxAttachment> qualityAttachment;
+
     juce::Label gainTitle;
     juce::Slider gainSlider;
     std::unique_ptr<SliderAttachment> gainAttachment;
@@ -70,5 +80,24 @@ private:
     juce::Slider lpfFreqSlider;
     std::unique_ptr<SliderAttachment> lpfFreqAttachment;
 
+    juce::ToggleButton binauralButton{"Binaural"};
+    std::unique_ptr<ButtonAttachment> binauralAttachment;
+
+    juce::TextButton hrirButton{"HRIR..."};
+    std::unique_ptr<juce::FileChooser> hrirChooser;
+
+    juce::TextButton auditButton{"Audit..."};
+    std::unique_ptr<juce::FileChooser> auditChooser;
+
+    juce::Label meterTitle;
+    OutputMeter outputMeter{audioProcessor};
+
+    juce::TextButton presetLibraryButton{"Presets..."};
+    std::unique_ptr<juce::FileChooser> presetLibraryChooser;
+    juce::ComboBox presetBox;
+    juce::TextEditor presetSearch;
+    static constexpr int maxListedPresets = 200;    //A ComboBox menu stays usable up to about this many items
+    void updatePresetBox();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StereoPanAudioProcessorEditor)
 };
@@ -18,6 +18,7 @@ StereoPanAudioProcessor::StereoPanAudioProcessor()
 #if ! JucePlugin_IsMidiEffect
 #if ! JucePlugin_IsSynth
         .withInput("Input", juce::AudioChannelSet::stereo(), true)
+        .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)
 #endif
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
@@ -35,6 +36,28 @@ StereoPanAudioProcessor::StereoPanAudioProcessor()
             std::make_unique<juce::AudioParameterBool>("rotationbypass", "rotationBypass", false),
             std::make_unique<juce::AudioParameterBool>("lpflink", "LPFLink", false),
             std::make_unique<juce::AudioParameterFloat>("lpffreq", "LPFFreq", juce::NormalisableRange<float>(1.0f, 20000.0f),20000.0f),
+            std::make_unique<juce::AudioParameterChoice>("quality", "Quality", juce::StringArray("Eco", "Standard", "High"), 1),
+            std::make_unique<juce::AudioParameterBool>("renderhigh", "RenderHigh", true),
+            std::make_unique<juce::AudioParameterChoice>("inputformat", "InputFormat", juce::StringArray("LR", "MS"), 0),
+            std::make_unique<juce::AudioParameterChoice>("outputformat", "OutputFormat", juce::StringArray("LR", "MS"), 0),
+            std::make_unique<juce::AudioParameterBool>("autowidth", "AutoWidth", false),
+            std::make_unique<juce::AudioParameterChoice>("autowidthmode", "AutoWidthMode", juce::StringArray("Correlation", "Side/Mid"), 0),
+            std::make_unique<juce::AudioParameterFloat>("autowidthcorr", "AutoWidthCorrelation", juce::NormalisableRange<float>(-1.0f, 1.0f), 0.5f),
+            std::make_unique<juce::AudioParameterFloat>("autowidthratio", "AutoWidthSideMid", juce::NormalisableRange<float>(0.0f, 1.0f), 0.25f),
+            std::make_unique<juce::AudioParameterBool>("autorotate", "AutoRotate", false),
+            std::make_unique<juce::AudioParameterChoice>("autorotaterate", "AutoRotateRate", juce::StringArray("4 Bars", "2 Bars", "1 Bar", "1/2", "1/4", "1/8", "1/16"), 2),
+            std::make_unique<juce::AudioParameterFloat>("autorotatedepth", "AutoRotateDepth", juce::NormalisableRange<float>(0.0f, 100.0f), 50.0f),
+            std::make_unique<juce::AudioParameterChoice>("autorotateshape", "AutoRotateShape", juce::StringArray("Sine", "Triangle"), 0),
+            std::make_unique<juce::AudioParameterFloat>("autorotatephase", "AutoRotatePhase", juce::NormalisableRange<float>(0.0f, 360.0f), 0.0f),
+            std::make_unique<juce::AudioParameterBool>("binaural", "Binaural", false),
+            std::make_unique<juce::AudioParameterFloat>("pitch", "Pitch", juce::NormalisableRange<float>(-100.0f, 100.0f), 0.0f),
+            std::make_unique<juce::AudioParameterFloat>("roll", "Roll", juce::NormalisableRange<float>(-100.0f, 100.0f), 0.0f),
+            std::make_unique<juce::AudioParameterBool>("transientwidth", "TransientWidth", false),
+            std::make_unique<juce::AudioParameterFloat>("sidechainwidth", "SidechainWidth", juce::NormalisableRange<float>(-100.0f, 100.0f), 0.0f),
+            std::make_unique<juce::AudioParameterFloat>("sidechainrotation", "SidechainRotation", juce::NormalisableRange<float>(-100.0f, 100.0f), 0.0f),
+            std::make_unique<juce::AudioParameterFloat>("sidechainthreshold", "SidechainThreshold", juce::NormalisableRange<float>(-60.0f, 0.0f), -30.0f),
+            std::make_unique<juce::AudioParameterFloat>("sidechainattack", "SidechainAttack", juce::NormalisableRange<float>(0.1f, 100.0f), 5.0f),
+            std::make_unique<juce::AudioParameterFloat>("sidechainrelease", "SidechainRelease", juce::NormalisableRange<float>(10.0f, 2000.0f), 200.0f),
         })
 {
     masterBypass = parameters.getRawParameterValue("masterbypass");
@@ -46,10 +69,34 @@ StereoPanAudioProcessor::StereoPanAudioProcessor()
     rotationBypass = parameters.getRawParameterValue("rotationbypass");
     lpfLink = parameters.getRawParameterValue("lpflink");
     lpfFreq = parameters.getRawParameterValue("lpffreq");
+    quality = parameters.getRawParameterValue("quality");
+    renderHigh = parameters.getRawParameterValue("renderhigh");
+    inputFormat = parameters.getRawParameterValue("inputformat");
+    outputFormat = parameters.getRawParameterValue("outputformat");
+    autoWidth = parameters.getRawParameterValue("autowidth");
+    autoWidthMode = parameters.getRawParameterValue("autowidthmode");
+    autoWidthCorrelation = parameters.getRawParameterValue("autowidthcorr");
+    autoWidthSideMid = parameters.getRawParameterValue("autowidthratio");
+    autoRotate = parameters.getRawParameterValue("autorotate");
+    autoRotateRate = parameters.getRawParameterValue("autorotaterate");
+    autoRotateDepth = parameters.getRawParameterValue("autorotatedepth");
+    autoRotateShape = parameters.getRawParameterValue("autorotateshape");
+    autoRotatePhase = parameters.getRawParameterValue("autorotatephase");
+    binaural = parameters.getRawParameterValue("binaural");
+    pitch = parameters.getRawParameterValue("pitch");
+    roll = parameters.getRawParameterValue("roll");
+    transientWidth = parameters.getRawParameterValue("transientwidth");
+    sidechainWidth = parameters.getRawParameterValue("sidechainwidth");
+    sidechainRotation = parameters.getRawParameterValue("sidechainrotation");
+    sidechainThreshold = parameters.getRawParameterValue("sidechainthreshold");
+    sidechainAttack = parameters.getRawParameterValue("sidechainattack");
+    sidechainRelease = parameters.getRawParameterValue("sidechainrelease");
 }
 
 StereoPanAudioProcessor::~StereoPanAudioProcessor()
 {
+    cancelPendingUpdate();
+    freeAllStates();
 }
 
 //==============================================================================
@@ -117,14 +164,110 @@ void StereoPanAudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void StereoPanAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Use this method as the place to do any pre-playback
-    // initialisation that you need..
+    //Everything for the new spec is allocated here; the audio thread only swaps it in
+    juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32)juce::jmax(1, samplesPerBlock), (juce::uint32)juce::jmax(1, getTotalNumOutputChannels()) };
+    preparedSpec = spec;
+    hasPreparedSpec = true;
+
+    //HRIRs are resampled to the session rate, so a rate change rebuilds them
+    if (hrirSet != nullptr && hrirSet->sampleRate != sampleRate){
+        juce::String error;
+        hrirSet = BinauralRenderer::loadHRIR(hrirSet->file, sampleRate, error);
+    }
+
+    publishState(buildState(spec));
 }
 
 void StereoPanAudioProcessor::releaseResources()
 {
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
+    //Processing has stopped; the next prepareToPlay() builds everything again
+    freeAllStates();
+    hasPreparedSpec = false;
+}
+
+std::unique_ptr<StereoPanAudioProcessor::PreparedState> StereoPanAudioProcessor::buildState(const juce::dsp::ProcessSpec& spec)
+{
+    std::unique_ptr<PreparedState> newState(new PreparedState(spec));
+
+    //First-order AmbiX on the main bus switches to the B-format rotator
+    newState->ambisonicLayout = getChannelLayoutOfBus(true, 0) == juce::AudioChannelSet::ambisonic(1);
+
+    //A fresh renderer per state, so its convolution history arrives clean with the swap
+    if (hrirSet != nullptr)
+        newState->binauralRenderer.reset(new BinauralRenderer(hrirSet));
+
+    return newState;
+}
+
+void StereoPanAudioProcessor::publishState(std::unique_ptr<PreparedState> newState)
+{
+    //Report the latency of the new configuration before its first block
+    int latency = 0;
+    if (binauralActive && newState->binauralRenderer != nullptr)
+        latency = BinauralRenderer::getLatencySamples();
+    else if (getEffectiveQuality() == Quality::high && !newState->ambisonicLayout)    //AmbiX is never oversampled
+        latency = juce::roundToInt(newState->oversampler.getLatencyInSamples());
+    pendingLatency.store(latency);
+    setLatencySamples(latency);
+
+    freeRetiredState();
+    delete pendingState.exchange(newState.release(), std::memory_order_acq_rel);
+}
+
+//==============================================================================
+StereoPanAudioProcessor::PreparedState::PreparedState(const juce::dsp::ProcessSpec& processSpec)
+    : spec(processSpec),
+      oversampler(2, 1, juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR, true)
+{
+    lowPassCoefficients = juce::dsp::IIR::Coefficients<double>::makeLowPass(spec.sampleRate, juce::jmin(20000.0, spec.sampleRate * 0.45), 0.7);
+    lowPassL.coefficients = lowPassCoefficients;
+    lowPassR.coefficients = lowPassCoefficients;
+
+    //Sizes the filter state now rather than on first use; High runs them at 2x
+    juce::dsp::ProcessSpec filterSpec { spec.sampleRate * 2.0, spec.maximumBlockSize * 2, 1 };
+    lowPassL.prepare(filterSpec);
+    lowPassR.prepare(filterSpec);
+
+    oversampler.initProcessing((size_t)spec.maximumBlockSize);
+    highPrecisionBuffer.setSize(2, (int)spec.maximumBlockSize);
+    transientCurve.assign((size_t)spec.maximumBlockSize * 2, 0.0f);
+    sidechainCurve.assign((size_t)spec.maximumBlockSize, 0.0f);
+}
+
+void StereoPanAudioProcessor::adoptPendingState()
+{
+    //Hold a new state back until the message thread has freed the previous retired one
+    if (retiredState.load(std::memory_order_acquire) != nullptr) return;
+
+    auto* next = pendingState.exchange(nullptr, std::memory_order_acq_rel);
+    if (next == nullptr) return;
+
+    if (preparedState != nullptr){
+        retiredState.store(preparedState, std::memory_order_release);
+        triggerAsyncUpdate();
+    }
+    preparedState = next;
+
+    //Everything tied to the rate restarts from the new state
+    currentSampleRate = preparedState->spec.sampleRate;
+    ambisonicLayout = preparedState->ambisonicLayout;
+    lastLPFSide = 0;
+    highBlockOverflow = false;
+    resetLowPass();
+    setQuality(getEffectiveQuality());
+}
+
+void StereoPanAudioProcessor::freeRetiredState()
+{
+    delete retiredState.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void StereoPanAudioProcessor::freeAllStates()
+{
+    freeRetiredState();
+    delete pendingState.exchange(nullptr, std::memory_order_acq_rel);
+    delete preparedState;
+    preparedState = nullptr;
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -139,7 +282,8 @@ bool StereoPanAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
     if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo()
+     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::ambisonic(1))
         return false;
 
     // This checks if the input layout matches the output layout
@@ -148,6 +292,15 @@ bool StereoPanAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
         return false;
    #endif
 
+    //Optional sidechain: off, mono or stereo
+    if (layouts.inputBuses.size() > 1){
+        auto sidechain = layouts.getChannelSet(true, 1);
+        if (!sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
+
     return true;
   #endif
 }
@@ -169,78 +322,787 @@ template <class sampleType>
 void StereoPanAudioProcessor::processBlockWrapper(juce::AudioBuffer<sampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    auto totalNumInputChannels = getMainBusNumInputChannels();    //The sidechain does not count
+    auto numSamples = buffer.getNumSamples();
+
+    //A configuration built by prepareToPlay() takes over here
+    adoptPendingState();
+    if (preparedState == nullptr) return;
+
+    if (*masterBypass != false){
+        publishBufferLevels(buffer, *inputFormat > 0.5f);
+        return;
+    }
+
+    /**** Post Gain only for mono layouts ****/
+    float valGain = *gain;
+    if (totalNumInputChannels < 2 || buffer.getNumChannels() < 2){
+        buffer.applyGain((sampleType)pow(valGain, 2));
+        publishBufferLevels(buffer, false);
+        return;
+    }
+
+    /**** Get LR (or MS) channels ****/
+    auto* leftChannel = buffer.getWritePointer(0);
+    auto* rightChannel = buffer.getWritePointer(1);
+
+    blockInputFormat = *inputFormat > 0.5f ? StereoMatrix::Format::ms : StereoMatrix::Format::lr;
+    blockOutputFormat = *outputFormat > 0.5f ? StereoMatrix::Format::ms : StereoMatrix::Format::lr;
+
+    /**** Select quality ****/
+    auto blockQuality = getEffectiveQuality();
+    if (blockQuality == Quality::high && numSamples > preparedState->highPrecisionBuffer.getNumSamples())
+        highBlockOverflow = true;   //Host exceeded the announced block size
+    if (blockQuality == Quality::high && highBlockOverflow)
+        blockQuality = Quality::standard;   //Sticky, so varying block sizes cannot toggle quality and latency
+
+    if (blockQuality != currentQuality)
+        setQuality(blockQuality);
+
+    /**** Caluculate angles of width and rotation ****/
+    float valWidth = *width;
+    float valRotation = *rotation;
+
+    float isWidthBypass = *widthBypass;
+    float isRotationBypass = *rotationBypass;
+
+    //In double: valWidth - 50 in float rounds for widths below 16
+    double Theta_w = M_PI / 200 * ((double)valWidth - 50);
+    if (isWidthBypass > 0.5f){  //Bypass width
+        Theta_w = 0.0;
+    }
+
+    //Auto width takes over Theta_w and steers it from the output statistics
+    bool isAutoWidth = *autoWidth > 0.5f && isWidthBypass <= 0.5f && !ambisonicLayout;
+    if (isAutoWidth){
+        if (!autoWidthActive){
+            autoWidthTheta = Theta_w;
+            autoWidthStatistics = {};
+            autoWidthActive = true;
+        }
+        Theta_w = autoWidthTheta;
+    }
+    else{
+        autoWidthActive = false;
+    }
+
+    blockStatistics = {};
+
+    double Theta_r = -M_PI / 400 * valRotation;
+    if (isRotationBypass > 0.5f){   //Bypass rotation
+        Theta_r = 0.0;
+    }
+
+    //Only a widening width stage has anything to hold back on transients
+    blockTransient = *transientWidth > 0.5f && (Theta_w > 0.0 || smoothedWidth.getCurrentValue() > 0.0);
+    if (blockTransient && !transientActive)
+        transientDetector.reset();
+    transientActive = blockTransient;
+
+    smoothedWidth.setTargetValue(Theta_w);
+    smoothedRotation.setTargetValue(Theta_r);
+    smoothedGain.setTargetValue(pow(valGain, 2) * (ambisonicLayout ? 1.0 : StereoMatrix::inputGain(blockInputFormat)));
+
+    if (ambisonicLayout && buffer.getNumChannels() >= 4){
+        processAmbisonic(buffer, isRotationBypass > 0.5f);
+        publishOutputLevels({});    //No L/R to meter
+        return;
+    }
+
+    //Binaural rendering replaces the matrix rotation and LPFLink
+    bool isBinaural = *binaural > 0.5f && preparedState->binauralRenderer != nullptr;
+    if (isBinaural != binauralActive){
+        binauralActive = isBinaural;
+        if (preparedState->binauralRenderer != nullptr)
+            preparedState->binauralRenderer->reset();
+        updateLatency();
+    }
+
+    //Auto rotation adds a tempo-synced LFO on top of Theta_r
+    blockAutoRotate = *autoRotate > 0.5f && isRotationBypass <= 0.5f;
+    if (blockAutoRotate)
+        syncRotationLFO(blockQuality == Quality::high && !isBinaural ? currentSampleRate * 2.0 : currentSampleRate);
+
+    //Sidechain level for the stereo matrix passes, read in place from its bus
+    sidechainCurve = isBinaural ? nullptr : getSidechainCurve(buffer, isWidthBypass > 0.5f, isRotationBypass > 0.5f);
+
+    //LPFLink follows the pushed rotation at the end of the block, as processModulated() does per interval
+    double lpfRotation = Theta_r;
+    if (sidechainCurve != nullptr && numSamples > 0)
+        lpfRotation += sidechainCurve[numSamples - 1] * sidechainRotationOffset;
+
+    double _frequency = getLPFFrequency(lpfRotation);
+    double _Q = 0.7;
+
+    int lpfSide = getLPFSide(lpfRotation);
+    setLPFSide(lpfSide);
+
+    /**** Apply stereo width, rotation, gain and LPFLink ****/
+    if (isBinaural)
+        processBinaural(leftChannel, rightChannel, numSamples);
+    else{
+        switch (blockQuality){
+        case Quality::eco:
+            if (blockAutoRotate)
+                processModulated(leftChannel, rightChannel, numSamples, currentSampleRate, ecoUpdateInterval, true);
+            else
+                processEco(leftChannel, rightChannel, numSamples, lpfSide, _frequency);
+            break;
+        case Quality::high:
+            processHigh(buffer, lpfSide, _frequency, _Q);
+            break;
+        default:
+            if (blockAutoRotate)
+                processModulated(leftChannel, rightChannel, numSamples, currentSampleRate, modulationInterval, false);
+            else
+                processStandard(leftChannel, rightChannel, numSamples, lpfSide, _frequency, _Q);
+            break;
+        }
+    }
+
+    if (isAutoWidth)
+        updateAutoWidth(numSamples / currentSampleRate);
+
+    //The binaural renderer reshapes the output after the matrix, so its sums do not describe it
+    if (isBinaural)
+        publishBufferLevels(buffer, false);
+    else
+        publishOutputLevels(blockStatistics);
+}
 
-    if (*masterBypass != false) return;
+template <class sampleType>
+void StereoPanAudioProcessor::processAmbisonic(juce::AudioBuffer<sampleType>& buffer, bool isRotationBypass)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    //Rotation drives yaw (same +-90 degrees as binaural), Pitch/Roll the other axes
+    smoothedPitch.setTargetValue(isRotationBypass ? 0.0 : M_PI / 200 * *pitch);
+    smoothedRoll.setTargetValue(isRotationBypass ? 0.0 : M_PI / 200 * *roll);
+
+    //Width trades W against the directional components; the stereo path's gain includes
+    //the L + R encode, hence the factor 2 to stay at unity for the default gain
+    auto startGains = StereoMatrix::makeWidthGains(smoothedWidth.getCurrentValue(), 2.0 * smoothedGain.getCurrentValue());
+    auto start = AmbisonicRotator::make(2.0 * smoothedRotation.getCurrentValue(), smoothedPitch.getCurrentValue(),
+                                        smoothedRoll.getCurrentValue(), startGains.mid, startGains.side);
+
+    auto endGains = StereoMatrix::makeWidthGains(smoothedWidth.skip(numSamples), 2.0 * smoothedGain.skip(numSamples));
+    auto end = AmbisonicRotator::make(2.0 * smoothedRotation.skip(numSamples), smoothedPitch.skip(numSamples),
+                                      smoothedRoll.skip(numSamples), endGains.mid, endGains.side);
+
+    //AmbiX / ACN channel order
+    AmbisonicRotator::process(buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getWritePointer(2),
+                              buffer.getWritePointer(3), numSamples, start, end);
+}
+
+template <class sampleType>
+void StereoPanAudioProcessor::processBinaural(sampleType* leftChannel, sampleType* rightChannel, int numSamples)
+{
+    //Width and gain still go through the matrix; rotation moves the virtual speakers instead
+    auto startGains = StereoMatrix::makeWidthGains(smoothedWidth.getCurrentValue(), smoothedGain.getCurrentValue());
+    auto endGains = StereoMatrix::makeWidthGains(smoothedWidth.skip(numSamples), smoothedGain.skip(numSamples));
+    double Theta_r = smoothedRotation.skip(numSamples);
+
+    if (blockAutoRotate){
+        double lfo = 0.0;
+        for (int i = 0; i < numSamples; ++i)
+            lfo = rotationLFO.next();
+        Theta_r += M_PI / 400 * *autoRotateDepth * lfo;
+    }
+
+    StereoMatrix::process(leftChannel, rightChannel, numSamples,
+                          StereoMatrix::make(startGains, 1.0, 0.0), StereoMatrix::make(endGains, 1.0, 0.0),
+                          blockInputFormat, StereoMatrix::Format::lr, getBlockStatistics());
+
+    //Full rotation (+-pi/4) swings the speakers by +-90 degrees
+    preparedState->binauralRenderer->process(leftChannel, rightChannel, numSamples, 2.0 * Theta_r);
+}
+
+juce::String StereoPanAudioProcessor::loadHRIR(const juce::File& file)
+{
+    //At the prepared rate, or a default one that the next prepareToPlay() corrects
+    juce::String error;
+    auto newSet = BinauralRenderer::loadHRIR(file, hasPreparedSpec ? preparedSpec.sampleRate : 44100.0, error);
+    if (newSet == nullptr)
+        return error;
+
+    hrirSet = std::move(newSet);
+    parameters.state.setProperty(hrirPathProperty, file.getFullPathName(), nullptr);
 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel){
-        /**** Get LR channels ****/
-        auto* leftChannel = buffer.getWritePointer(0);
-        auto* rightChannel = buffer.getWritePointer(1);
+    //The audio thread picks the new renderer up with the rest of a rebuilt state
+    if (hasPreparedSpec)
+        publishState(buildState(preparedSpec));
 
-        /**** Caluculate angles of width and rotation ****/
-        float valWidth = *width;
-        float valRotation = *rotation;
+    return {};
+}
+
+juce::File StereoPanAudioProcessor::getHRIRFile() const
+{
+    return hrirSet != nullptr ? hrirSet->file : juce::File();
+}
+
+bool StereoPanAudioProcessor::startAudit(const juce::File& folder, std::function<void(const juce::String&)> onFinished)
+{
+    if (audit != nullptr && !audit->isFinished())
+        return false;
+
+    audit.reset(new StereoFieldAnalyzer::BatchAudit(folder, StereoFieldAnalyzer::Settings(), std::move(onFinished)));
+    return true;
+}
 
-        float isWidthBypass = *widthBypass;
-        float isRotationBypass = *rotationBypass;
+juce::String StereoPanAudioProcessor::loadPresetLibrary(const juce::File& file)
+{
+    juce::String error;
+    auto library = PresetLibrary::open(file, error);
+    if (library == nullptr)
+        return error;
 
-        double Theta_w = M_PI / 200 * (valWidth - 50);
-        if (isWidthBypass > 0.5f){  //Bypass width
-            Theta_w = 0.0;
+    presetLibrary = std::move(library);
+    parameters.state.setProperty(presetLibraryProperty, file.getFullPathName(), nullptr);
+    return {};
+}
+
+void StereoPanAudioProcessor::applyPreset(int preset)
+{
+    if (presetLibrary == nullptr || !juce::isPositiveAndBelow(preset, presetLibrary->getNumPresets()))
+        return;
+
+    //Values come straight from the mapped record; IDs this build does not know are skipped
+    for (int i = 0; i < presetLibrary->getNumParameters(); ++i){
+        if (auto* parameter = parameters.getParameter(presetLibrary->getParameterID(i))){
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(presetLibrary->getValue(preset, i)));
+            parameter->endChangeGesture();
         }
+    }
+}
+
+PresetLibrary::Entry StereoPanAudioProcessor::capturePreset(const juce::String& name, const juce::StringArray& tags)
+{
+    std::unique_ptr<juce::XmlElement> xml(parameters.copyState().createXml());
+    return PresetLibrary::makeEntry(name, tags, *xml, getParameterIDs());
+}
+
+juce::StringArray StereoPanAudioProcessor::getParameterIDs() const
+{
+    juce::StringArray ids;
+    for (auto* parameter : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            ids.add(withID->paramID);
+    return ids;
+}
+
+StereoPanAudioProcessor::OutputLevels StereoPanAudioProcessor::getOutputLevels() const
+{
+    OutputLevels levels;
+    levels.block = meterBlock.load(std::memory_order_acquire);
+    levels.peak = meterPeak.load(std::memory_order_relaxed);
+    levels.rms = meterRMS.load(std::memory_order_relaxed);
+    levels.sideToMid = meterSideToMid.load(std::memory_order_relaxed);
+    levels.correlation = meterCorrelation.load(std::memory_order_relaxed);
+    return levels;
+}
 
-        double Theta_r = -M_PI / 400 * valRotation;
-        if (isRotationBypass > 0.5f){   //Bypass rotation
-            Theta_r = 0.0;
+void StereoPanAudioProcessor::publishOutputLevels(const StereoMatrix::Statistics& statistics)
+{
+    meterPeak.store((float)statistics.peak, std::memory_order_relaxed);
+    meterRMS.store((float)statistics.getRMS(), std::memory_order_relaxed);
+    meterSideToMid.store((float)statistics.getSideToMidRatio(), std::memory_order_relaxed);
+    meterCorrelation.store((float)statistics.getCorrelation(), std::memory_order_relaxed);
+    meterBlock.fetch_add(1, std::memory_order_release);
+}
+
+template <class sampleType>
+void StereoPanAudioProcessor::publishBufferLevels(const juce::AudioBuffer<sampleType>& buffer, bool isMS)
+{
+    StereoMatrix::Statistics statistics;
+
+    if (buffer.getNumChannels() > 0){
+        const int numSamples = buffer.getNumSamples();
+        auto* first = buffer.getReadPointer(0);
+        auto* second = buffer.getReadPointer(juce::jmin(1, buffer.getNumChannels() - 1));
+
+        //Same halves as the matrix pass: L = mid + side, R = mid - side
+        for (int i = 0; i < numSamples; ++i){
+            const double mid = isMS ? (double)first[i] : 0.5 * ((double)first[i] + second[i]);
+            const double side = isMS ? (double)second[i] : 0.5 * ((double)first[i] - second[i]);
+            statistics.midEnergy += mid * mid;
+            statistics.sideEnergy += side * side;
+            statistics.midSide += mid * side;
+            statistics.peak = juce::jmax(statistics.peak, std::abs(mid) + std::abs(side));
         }
+        statistics.numSamples = numSamples;
+    }
+
+    publishOutputLevels(statistics);
+}
+
+void StereoPanAudioProcessor::updateAutoWidth(double blockSeconds)
+{
+    //Hold the current width through silence instead of drifting on noise
+    if (blockStatistics.midEnergy + blockStatistics.sideEnergy < 1.0e-8 * blockSeconds * currentSampleRate)
+        return;
+
+    autoWidthStatistics.accumulate(blockStatistics, std::exp(-blockSeconds / autoWidthTimeConstant));
+
+    double error;
+    if (*autoWidthMode > 0.5f)
+        error = *autoWidthSideMid - autoWidthStatistics.getSideToMidRatio();
+    else
+        error = autoWidthStatistics.getCorrelation() - *autoWidthCorrelation;
+
+    //Integrating controller; the result reaches the matrix through smoothedWidth
+    autoWidthTheta = juce::jlimit(-M_PI / 4, M_PI / 4, autoWidthTheta + autoWidthRate * error * blockSeconds);
+}
+
+//==============================================================================
+StereoPanAudioProcessor::Quality StereoPanAudioProcessor::getEffectiveQuality() const
+{
+    if (isNonRealtime() && *renderHigh > 0.5f)
+        return Quality::high;
+
+    return (Quality)juce::jlimit(0, 2, juce::roundToInt(quality->load()));
+}
+
+void StereoPanAudioProcessor::setQuality(Quality newQuality)
+{
+    const Quality previousQuality = currentQuality;
+    currentQuality = newQuality;
+
+    //High runs its ramps at the oversampled rate; the AmbiX rotator stays at the host rate
+    double rampRate = newQuality == Quality::high && !ambisonicLayout ? currentSampleRate * 2.0 : currentSampleRate;
+    for (auto* smoothed : { &smoothedWidth, &smoothedRotation, &smoothedGain, &smoothedPitch, &smoothedRoll })
+        retuneSmoothing(*smoothed, rampRate);
+    transientDetector.setSampleRate(rampRate);
+
+    //Filters that were running keep their state; only the ones that sat idle start clean
+    if ((previousQuality == Quality::eco) != (newQuality == Quality::eco))
+        resetLowPass();     //Eco's one-pole and the biquads take turns
+    if (newQuality == Quality::high && previousQuality != Quality::high)
+        preparedState->oversampler.reset();
 
-        float valLPFFreq = *lpfFreq;
-        double LPFBias = abs(valRotation) / 100;
-        double _frequency = LPFBias * valLPFFreq + (1 - LPFBias) * 20000.0f;
-        double _Q = 0.7;
-        bool isLPFBypass = *lpfLink;
-
-        //Get the sampling rate
-        double _samplerate = getSampleRate();
-
-        /**** Apply stereo width and rotation ****/
-        for (int i = 0; i < buffer.getNumSamples(); ++i){
-            //Generate MS signals
-            auto midInput = (leftChannel[i] + rightChannel[i]);
-            auto sideInput = (leftChannel[i] - rightChannel[i]);
-
-            auto midWidth = midInput * sin(M_PI / 4 - Theta_w) * sqrt(2);
-            auto sideWidth = sideInput * cos(M_PI / 4 - Theta_w) * sqrt(2);
-
-            //Processing rotation
-            auto midRotation = midWidth * cos(Theta_r) - sideWidth * sin(Theta_r);
-            auto sideRotation = midWidth * sin(Theta_r) + sideWidth * cos(Theta_r);
-            //Revert to LR signals
-            leftChannel[i] = (midRotation + sideRotation);
-            rightChannel[i] = (midRotation - sideRotation);
-            //Apply LPFLink
-            if (isLPFBypass > 0.5f){
-                if (Theta_r > 0.0){
-                    LowPassR.reset();
-                    LowPassR.coefficients = juce::dsp::IIR::Coefficients<double>::makeLowPass(_samplerate, _frequency, _Q);
-                    rightChannel[i] = LowPassR.processSample(rightChannel[i]);
-                }
-                else if (Theta_r < 0.0){
-                    LowPassL.reset();
-                    LowPassL.coefficients = juce::dsp::IIR::Coefficients<double>::makeLowPass(_samplerate, _frequency, _Q);
-                    leftChannel[i] = LowPassL.processSample(leftChannel[i]);
-                }
+    updateLatency();
+}
+
+void StereoPanAudioProcessor::retuneSmoothing(juce::SmoothedValue<double>& smoothed, double rampRate)
+{
+    //reset() snaps to the target; restart the ramp from where it was instead
+    const double current = smoothed.getCurrentValue();
+    const double target = smoothed.getTargetValue();
+    smoothed.reset(rampRate, smoothingTimeSeconds);
+    smoothed.setCurrentAndTargetValue(current);
+    smoothed.setTargetValue(target);
+}
+
+void StereoPanAudioProcessor::updateLatency()
+{
+    int newLatency = 0;
+    if (binauralActive)
+        newLatency = BinauralRenderer::getLatencySamples();
+    else if (currentQuality == Quality::high && !ambisonicLayout)
+        newLatency = juce::roundToInt(preparedState->oversampler.getLatencyInSamples());
+
+    if (newLatency != pendingLatency.exchange(newLatency))
+        triggerAsyncUpdate();
+}
+
+void StereoPanAudioProcessor::handleAsyncUpdate()
+{
+    freeRetiredState();
+    setLatencySamples(pendingLatency.load());
+}
+
+StereoMatrix::Coefficients StereoPanAudioProcessor::getCurrentMatrix() const
+{
+    return StereoMatrix::make(smoothedWidth.getCurrentValue(), smoothedRotation.getCurrentValue(), smoothedGain.getCurrentValue());
+}
+
+template <class sampleType>
+const float* StereoPanAudioProcessor::getTransientCurve(const sampleType* first, const sampleType* second, int numSamples)
+{
+    if (!blockTransient || numSamples > (int)preparedState->transientCurve.size())
+        return nullptr;
+
+    transientDetector.process(first, second, numSamples, blockInputFormat == StereoMatrix::Format::ms, preparedState->transientCurve.data());
+    return preparedState->transientCurve.data();
+}
+
+StereoMatrix::WidthGains StereoPanAudioProcessor::getTransientGains(const StereoMatrix::WidthGains& widthGains, double Theta_w, double gain)
+{
+    //Neutral width is equal mid and side gain; narrowing settings are left alone
+    if (Theta_w <= 0.0) return widthGains;
+
+    StereoMatrix::WidthGains g;
+    g.mid = gain;
+    g.side = gain;
+    return g;
+}
+
+StereoMatrix::Coefficients StereoPanAudioProcessor::getCurrentTransientMatrix() const
+{
+    double Theta_w = smoothedWidth.getCurrentValue();
+    double Theta_r = smoothedRotation.getCurrentValue();
+    double outputGain = smoothedGain.getCurrentValue();
+
+    auto g = getTransientGains(StereoMatrix::makeWidthGains(Theta_w, outputGain), Theta_w, outputGain);
+    return StereoMatrix::make(g, cos(Theta_r), sin(Theta_r));
+}
+
+template <class sampleType>
+const float* StereoPanAudioProcessor::getSidechainCurve(juce::AudioBuffer<sampleType>& buffer, bool isWidthBypass, bool isRotationBypass)
+{
+    sidechainWidthOffset = isWidthBypass ? 0.0 : M_PI / 200 * *sidechainWidth;
+    sidechainRotationOffset = isRotationBypass ? 0.0 : -M_PI / 400 * *sidechainRotation;
+
+    //An unconnected bus or zero depths cost only this check
+    auto* bus = getBus(true, 1);
+    bool isActive = bus != nullptr && bus->isEnabled() && bus->getNumberOfChannels() > 0
+                 && (sidechainWidthOffset != 0.0 || sidechainRotationOffset != 0.0)
+                 && buffer.getNumSamples() <= (int)preparedState->sidechainCurve.size();
+
+    if (isActive && !sidechainActive)
+        sidechainEnvelope.reset();
+    sidechainActive = isActive;
+    if (!isActive) return nullptr;
+
+    auto sidechain = getBusBuffer(buffer, true, 1);
+    sidechainEnvelope.setTimes(*sidechainAttack / 1000.0, *sidechainRelease / 1000.0, currentSampleRate);
+    sidechainEnvelope.process(sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(), sidechain.getNumSamples(),
+                              juce::Decibels::decibelsToGain(sidechainThreshold->load()), preparedState->sidechainCurve.data());
+    return preparedState->sidechainCurve.data();
+}
+
+double StereoPanAudioProcessor::getSidechainWidth(double Theta_w, double amount) const
+{
+    return juce::jlimit(-M_PI / 4, M_PI / 4, Theta_w + amount * sidechainWidthOffset);
+}
+
+StereoMatrix::Coefficients StereoPanAudioProcessor::getPushedMatrix(double Theta_w, double Theta_r, double outputGain,
+                                                                   double sidechainAmount, double transientAmount) const
+{
+    //The sidechain offsets the angles themselves, so a push turns the image without
+    //the level dip a blend between two rotation matrices would have
+    Theta_w = getSidechainWidth(Theta_w, sidechainAmount);
+    Theta_r += sidechainAmount * sidechainRotationOffset;
+
+    auto g = StereoMatrix::makeWidthGains(Theta_w, outputGain);
+    if (transientAmount > 0.0)
+        g = StereoMatrix::mix(g, getTransientGains(g, Theta_w, outputGain), transientAmount);
+
+    return StereoMatrix::make(g, cos(Theta_r), sin(Theta_r));
+}
+
+int StereoPanAudioProcessor::getLPFSide(double Theta_r) const
+{
+    if (*lpfLink <= 0.5f) return 0;
+    return StereoMatrix::getLowPassLinkSide(Theta_r);
+}
+
+double StereoPanAudioProcessor::getLPFFrequency(double Theta_r) const
+{
+    return StereoMatrix::getLowPassLinkFrequency(Theta_r, *lpfFreq);
+}
+
+void StereoPanAudioProcessor::setLPFSide(int lpfSide)
+{
+    if (lpfSide != lastLPFSide){
+        //The filter that just became active must not ring with stale state
+        resetLowPass();
+        lastLPFSide = lpfSide;
+    }
+}
+
+double StereoPanAudioProcessor::getOnePoleCoefficient(double frequency, double sampleRate)
+{
+    return 1.0 - std::exp(-2.0 * M_PI * juce::jmin(frequency, sampleRate * 0.5) / sampleRate);
+}
+
+void StereoPanAudioProcessor::syncRotationLFO(double sampleRate)
+{
+    //Beats per LFO cycle for each AutoRotateRate choice (4/4)
+    static const double beatsPerCycle[] = { 16.0, 8.0, 4.0, 2.0, 1.0, 0.5, 0.25 };
+    double beats = beatsPerCycle[juce::jlimit(0, 6, juce::roundToInt(autoRotateRate->load()))];
+
+    double bpm = 120.0;
+    bool isPlaying = false;
+    double ppqPosition = 0.0;
+
+    if (auto* playHead = getPlayHead()){
+        juce::AudioPlayHead::CurrentPositionInfo info;
+        if (playHead->getCurrentPosition(info)){
+            if (info.bpm > 0.0) bpm = info.bpm;
+            isPlaying = info.isPlaying;
+            ppqPosition = info.ppqPosition;
+        }
+    }
+
+    //Locked to the song position while playing, free-running otherwise
+    double phase = isPlaying ? ppqPosition / beats + *autoRotatePhase / 360.0 : rotationLFO.getPhase();
+    auto shape = *autoRotateShape > 0.5f ? RotationLFO::Shape::triangle : RotationLFO::Shape::sine;
+
+    rotationLFO.sync(phase, bpm / 60.0 / beats / sampleRate, shape);
+}
+
+template <class sampleType>
+void StereoPanAudioProcessor::processModulated(sampleType* leftChannel, sampleType* rightChannel, int numSamples,
+                                               double sampleRate, int controlInterval, bool useOnePole)
+{
+    const auto& sineTable = SineTable::getInstance();
+    const double depth = M_PI / 400 * *autoRotateDepth;
+    const float* curve = getTransientCurve(leftChannel, rightChannel, numSamples);
+    const int sidechainShift = sampleRate > currentSampleRate ? 1 : 0;     //High runs at twice the curve's rate
+
+    for (int start = 0; start < numSamples; start += controlInterval){
+        int num = juce::jmin(numSamples - start, controlInterval);
+
+        //Width and gain ramp across the control interval, rotation moves every sample
+        double startWidth = smoothedWidth.getCurrentValue(), startGain = smoothedGain.getCurrentValue();
+        auto startGains = StereoMatrix::makeWidthGains(startWidth, startGain);
+        double startRotation = smoothedRotation.getCurrentValue();
+
+        double endWidth = smoothedWidth.skip(num), endGain = smoothedGain.skip(num);
+        auto endGains = StereoMatrix::makeWidthGains(endWidth, endGain);
+        double endRotation = smoothedRotation.skip(num);
+
+        const double step = 1.0 / num;
+        int index = 0;
+        double angle = startRotation;
+
+        auto nextCoefficients = [&](){
+            double t = ++index * step;
+            angle = startRotation + (endRotation - startRotation) * t + depth * rotationLFO.next();
+
+            double Theta_w = startWidth + (endWidth - startWidth) * t;
+            const double outputGain = startGain + (endGain - startGain) * t;
+            auto g = StereoMatrix::mix(startGains, endGains, t);
+
+            //The sidechain offsets both angles, as in High
+            if (sidechainCurve != nullptr){
+                const double amount = sidechainCurve[(start + index - 1) >> sidechainShift];
+                angle += amount * sidechainRotationOffset;
+                Theta_w = getSidechainWidth(Theta_w, amount);
+                g = StereoMatrix::makeWidthGains(Theta_w, outputGain);
             }
+
+            if (curve != nullptr)
+                g = StereoMatrix::mix(g, getTransientGains(g, Theta_w, outputGain), curve[start + index - 1]);
+
+            return StereoMatrix::make(g, sineTable.cos(angle), sineTable.sin(angle));
+        };
+
+        StereoMatrix::processEachSample(leftChannel + start, rightChannel + start, num, nextCoefficients,
+                                        blockInputFormat, blockOutputFormat, getBlockStatistics());
+
+        //LPFLink follows the modulated angle at control rate, coefficients updated in place
+        int lpfSide = getLPFSide(angle);
+        setLPFSide(lpfSide);
+        if (lpfSide == 0) continue;
+
+        double frequency = getLPFFrequency(angle);
+        if (useOnePole){
+            double a = getOnePoleCoefficient(frequency, sampleRate);
+            double& state = lpfSide > 0 ? ecoLowPassStateR : ecoLowPassStateL;
+            StereoMatrix::processLowPassLink(leftChannel + start, rightChannel + start, num, lpfSide, blockOutputFormat,
+                [&state, a](double x){ return state += a * (x - state); });
+        }
+        else{
+            updateLowPassCoefficients(sampleRate, frequency, 0.7);
+            auto& filter = lpfSide > 0 ? preparedState->lowPassR : preparedState->lowPassL;
+            StereoMatrix::processLowPassLink(leftChannel + start, rightChannel + start, num, lpfSide, blockOutputFormat,
+                [&filter](double x){ return filter.processSample(x); });
         }
+    }
+}
+
+void StereoPanAudioProcessor::resetLowPass()
+{
+    preparedState->lowPassL.reset();
+    preparedState->lowPassR.reset();
+    ecoLowPassStateL = 0.0;
+    ecoLowPassStateR = 0.0;
+}
+
+template <class sampleType>
+void StereoPanAudioProcessor::processEco(sampleType* leftChannel, sampleType* rightChannel, int numSamples, int lpfSide, double frequency)
+{
+    const float* curve = getTransientCurve(leftChannel, rightChannel, numSamples);
+
+    //Parameters are only picked up every ecoUpdateInterval samples
+    for (int start = 0; start < numSamples; start += ecoUpdateInterval){
+        int num = juce::jmin(numSamples - start, (int)ecoUpdateInterval);
+
+        smoothedWidth.skip(num);
+        smoothedRotation.skip(num);
+        smoothedGain.skip(num);
+
+        //Transient and sidechain amounts averaged over the interval
+        double transientAmount = 0.0, sidechainAmount = 0.0;
+        if (curve != nullptr){
+            for (int i = 0; i < num; ++i)
+                transientAmount += curve[start + i];
+            transientAmount /= num;
+        }
+        if (sidechainCurve != nullptr){
+            for (int i = 0; i < num; ++i)
+                sidechainAmount += sidechainCurve[start + i];
+            sidechainAmount /= num;
+        }
+
+        auto matrix = curve != nullptr || sidechainCurve != nullptr
+                    ? getPushedMatrix(smoothedWidth.getCurrentValue(), smoothedRotation.getCurrentValue(), smoothedGain.getCurrentValue(),
+                                      sidechainAmount, transientAmount)
+                    : getCurrentMatrix();
+
+        StereoMatrix::process(leftChannel + start, rightChannel + start, num, matrix, blockInputFormat, blockOutputFormat, getBlockStatistics());
+    }
+
+    //One-pole LPFLink instead of the biquad
+    if (lpfSide == 0) return;
+
+    double a = getOnePoleCoefficient(frequency, currentSampleRate);
+    double& state = lpfSide > 0 ? ecoLowPassStateR : ecoLowPassStateL;
+
+    StereoMatrix::processLowPassLink(leftChannel, rightChannel, numSamples, lpfSide, blockOutputFormat,
+        [&state, a](double x){ return state += a * (x - state); });
+}
+
+template <class sampleType>
+void StereoPanAudioProcessor::processStandard(sampleType* leftChannel, sampleType* rightChannel, int numSamples, int lpfSide, double frequency, double Q)
+{
+    //Matrix coefficients are ramped linearly across the block
+    auto start = getCurrentMatrix();
+    auto startNeutral = getCurrentTransientMatrix();
+    const double startWidth = smoothedWidth.getCurrentValue();
+    const double startRotation = smoothedRotation.getCurrentValue();
+    const double startGain = smoothedGain.getCurrentValue();
+
+    const double endWidth = smoothedWidth.skip(numSamples);
+    const double endRotation = smoothedRotation.skip(numSamples);
+    const double endGain = smoothedGain.skip(numSamples);
+
+    auto end = getCurrentMatrix();
+    const float* curve = getTransientCurve(leftChannel, rightChannel, numSamples);
+    const double step = 1.0 / numSamples;
+    int index = 0;
+
+    if (sidechainCurve != nullptr){
+        //The sidechain pushes the angles, so they are ramped and the matrix rebuilt every sample as in High
+        StereoMatrix::processEachSample(leftChannel, rightChannel, numSamples,
+            [&](){
+                const double t = ++index * step;
+                return getPushedMatrix(startWidth + (endWidth - startWidth) * t,
+                                       startRotation + (endRotation - startRotation) * t,
+                                       startGain + (endGain - startGain) * t,
+                                       sidechainCurve[index - 1], curve != nullptr ? curve[index - 1] : 0.0);
+            },
+            blockInputFormat, blockOutputFormat, getBlockStatistics());
+    }
+    else if (curve != nullptr){
+        //Same ramp, blended per sample towards the neutral-width ramp
+        auto endNeutral = getCurrentTransientMatrix();
+
+        StereoMatrix::processEachSample(leftChannel, rightChannel, numSamples,
+            [&](){
+                const double t = ++index * step;
+                return StereoMatrix::mix(StereoMatrix::mix(start, end, t), StereoMatrix::mix(startNeutral, endNeutral, t), curve[index - 1]);
+            },
+            blockInputFormat, blockOutputFormat, getBlockStatistics(), StereoMatrix::getFeatures(start, end));
+    }
+    else{
+        StereoMatrix::process(leftChannel, rightChannel, numSamples, start, end, blockInputFormat, blockOutputFormat, getBlockStatistics());
+    }
+
+    //Apply LPFLink
+    if (lpfSide == 0) return;
+
+    updateLowPassCoefficients(currentSampleRate, frequency, Q);
+
+    auto& filter = lpfSide > 0 ? preparedState->lowPassR : preparedState->lowPassL;
+    StereoMatrix::processLowPassLink(leftChannel, rightChannel, numSamples, lpfSide, blockOutputFormat,
+        [&filter](double x){ return filter.processSample(x); });
+}
+
+void StereoPanAudioProcessor::processHigh(juce::AudioBuffer<float>& buffer, int lpfSide, double frequency, double Q)
+{
+    //Run in double precision on the preallocated scratch buffer
+    const int numSamples = buffer.getNumSamples();
 
-        /**** Post Gain ****/
-        float valGain = *gain;
-        buffer.applyGain(pow(valGain, 2));
+    for (int channel = 0; channel < 2; ++channel){
+        auto* src = buffer.getReadPointer(channel);
+        auto* dst = preparedState->highPrecisionBuffer.getWritePointer(channel);
+        for (int i = 0; i < numSamples; ++i)
+            dst[i] = src[i];
+    }
+
+    juce::dsp::AudioBlock<double> block(preparedState->highPrecisionBuffer);
+    processHighBlock(block.getSubsetChannelBlock(0, 2).getSubBlock(0, (size_t)numSamples), lpfSide, frequency, Q);
+
+    for (int channel = 0; channel < 2; ++channel){
+        auto* src = preparedState->highPrecisionBuffer.getReadPointer(channel);
+        auto* dst = buffer.getWritePointer(channel);
+        for (int i = 0; i < numSamples; ++i)
+            dst[i] = (float)src[i];
     }
 }
 
+void StereoPanAudioProcessor::processHigh(juce::AudioBuffer<double>& buffer, int lpfSide, double frequency, double Q)
+{
+    juce::dsp::AudioBlock<double> block(buffer);
+    processHighBlock(block.getSubsetChannelBlock(0, 2), lpfSide, frequency, Q);
+}
+
+void StereoPanAudioProcessor::processHighBlock(juce::dsp::AudioBlock<double> block, int lpfSide, double frequency, double Q)
+{
+    auto upBlock = preparedState->oversampler.processSamplesUp(block);
+    auto* leftChannel = upBlock.getChannelPointer(0);
+    auto* rightChannel = upBlock.getChannelPointer(1);
+    const int numSamples = (int)upBlock.getNumSamples();
+
+    if (blockAutoRotate){
+        processModulated(leftChannel, rightChannel, numSamples, currentSampleRate * 2.0, modulationInterval * 2, false);
+        preparedState->oversampler.processSamplesDown(block);
+        return;
+    }
+
+    //Per-sample ramps of the angles themselves; every step lies between the current and target matrix
+    auto target = StereoMatrix::make(smoothedWidth.getTargetValue(), smoothedRotation.getTargetValue(), smoothedGain.getTargetValue());
+
+    const float* curve = getTransientCurve(leftChannel, rightChannel, numSamples);
+    int index = 0;
+
+    //The sidechain can push either angle anywhere, so it needs the full kernel
+    int features = sidechainCurve != nullptr ? (int)StereoMatrix::Feature::all : StereoMatrix::getFeatures(getCurrentMatrix(), target);
+
+    StereoMatrix::processEachSample(leftChannel, rightChannel, numSamples,
+        [&](){
+            const int i = index++;
+            double Theta_w = smoothedWidth.getNextValue();
+            double Theta_r = smoothedRotation.getNextValue();
+            double outputGain = smoothedGain.getNextValue();
+
+            //Sidechain amount at the host rate
+            return getPushedMatrix(Theta_w, Theta_r, outputGain, sidechainCurve != nullptr ? sidechainCurve[i >> 1] : 0.0,
+                                   curve != nullptr ? curve[i] : 0.0);
+        },
+        blockInputFormat, blockOutputFormat, getBlockStatistics(), features);
+
+    //LPFLink at the oversampled rate
+    if (lpfSide != 0){
+        updateLowPassCoefficients(currentSampleRate * 2.0, frequency, Q);
+
+        auto& filter = lpfSide > 0 ? preparedState->lowPassR : preparedState->lowPassL;
+        StereoMatrix::processLowPassLink(leftChannel, rightChannel, numSamples, lpfSide, blockOutputFormat,
+            [&filter](double x){ return filter.processSample(x); });
+    }
+
+    preparedState->oversampler.processSamplesDown(block);
+}
+
+void StereoPanAudioProcessor::updateLowPassCoefficients(double sampleRate, double frequency, double Q)
+{
+    //Written into the shared coefficient object so the audio thread never allocates
+    StereoMatrix::makeLowPass(sampleRate, frequency, Q, preparedState->lowPassCoefficients->getRawCoefficients());
+}
+
 bool StereoPanAudioProcessor::supportsDoublePrecisionProcessing() const
 {
     return true;
@@ -272,6 +1134,15 @@ void StereoPanAudioProcessor::setStateInformation (const void* data, int sizeInB
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName(parameters.state.getType()))
             parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+
+    //Reload the HRIR set the session was saved with
+    juce::File hrirFile(parameters.state.getProperty(hrirPathProperty).toString());
+    if (hrirFile.existsAsFile() && hrirFile != getHRIRFile())
+        loadHRIR(hrirFile);
+
+    juce::File libraryFile(parameters.state.getProperty(presetLibraryProperty).toString());
+    if (libraryFile.existsAsFile() && (presetLibrary == nullptr || libraryFile != presetLibrary->getFile()))
+        loadPresetLibrary(libraryFile);
 }
 
 //==============================================================================
@@ -9,11 +9,20 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "StereoMatrix.h"
+#include "RotationLFO.h"
+#include "BinauralRenderer.h"
+#include "AmbisonicRotator.h"
+#include "StereoFieldAnalyzer.h"
+#include "TransientDetector.h"
+#include "PresetLibrary.h"
+#include "SidechainEnvelope.h"
 
 //==============================================================================
 /**
 */
-class StereoPanAudioProcessor  : public juce::AudioProcessor
+class StereoPanAudioProcessor  : public juce::AudioProcessor,
+                                 private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -59,6 +68,46 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    /** Loads the HRIR set used by the binaural mode; see BinauralRenderer for the
+        file layout. Call from the message thread. The renderer reaches the audio thread
+        inside a new PreparedState. Returns an error message or an empty string. */
+    juce::String loadHRIR(const juce::File& file);
+    juce::File getHRIRFile() const;
+
+    /** Starts an offline stereo-field audit of every audio file below folder on a
+        background thread; see StereoFieldAnalyzer::BatchAudit. Returns false if one
+        is already running. */
+    bool startAudit(const juce::File& folder, std::function<void(const juce::String&)> onFinished);
+
+    /** Output levels of the most recent block. The stereo paths measure inside the matrix
+        pass, so the levels are taken before LPF-Link and, in High, at the oversampled rate.
+        Bypass, mono and binaural measure their output buffer; AmbiX publishes silence.
+        block counts published blocks, so readers can tell whether anything changed. */
+    struct OutputLevels
+    {
+        float peak = 0.0f;
+        float rms = 0.0f;
+        float sideToMid = 0.0f;
+        float correlation = 0.0f;
+        juce::uint32 block = 0;
+    };
+
+    OutputLevels getOutputLevels() const;
+
+    /** Opens a preset library (see PresetLibrary) and remembers it in the state.
+        Message thread. Returns an error message or an empty string. */
+    juce::String loadPresetLibrary(const juce::File& file);
+    std::shared_ptr<const PresetLibrary> getPresetLibrary() const { return presetLibrary; }
+
+    /** Sets every parameter the preset stores, as a host-visible change. Message thread. */
+    void applyPreset(int preset);
+
+    /** Current parameter values as a library entry, for building libraries with PresetLibrary::write()
+        (see Tools/PresetImporter). */
+    PresetLibrary::Entry capturePreset(const juce::String& name, const juce::StringArray& tags);
+    juce::StringArray getParameterIDs() const;
+
 private:
     juce::AudioProcessorValueTreeState parameters;
     std::atomic<float>* masterBypass = nullptr;
@@ -69,8 +118,198 @@ private:
     std::atomic<float>* rotationBypass = nullptr;
     std::atomic<float>* lpfLink = nullptr;
     std::atomic<float>* lpfFreq = nullptr;
+    std::atomic<float>* quality = nullptr;
+    std::atomic<float>* renderHigh = nullptr;
+    std::atomic<float>* inputFormat = nullptr;
+    std::atomic<float>* outputFormat = nullptr;
+
+    StereoMatrix::Format blockInputFormat = StereoMatrix::Format::lr;
+    StereoMatrix::Format blockOutputFormat = StereoMatrix::Format::lr;
+
+    /** Auto width: an integrating controller on Theta_w that holds the output at a
+        target L/R correlation or side/mid energy ratio. The statistics are running
+        sums taken inside the matrix pass and leaky-integrated once per block. */
+    std::atomic<float>* autoWidth = nullptr;
+    std::atomic<float>* autoWidthMode = nullptr;
+    std::atomic<float>* autoWidthCorrelation = nullptr;
+    std::atomic<float>* autoWidthSideMid = nullptr;
+    static constexpr double autoWidthTimeConstant = 0.3;
+    static constexpr double autoWidthRate = 0.5;
+
+    bool autoWidthActive = false;
+    double autoWidthTheta = 0.0;
+    StereoMatrix::Statistics autoWidthStatistics;
+    StereoMatrix::Statistics blockStatistics;
+
+    //Every stereo pass measures its output; auto width and the meters share the sums
+    StereoMatrix::Statistics* getBlockStatistics() { return &blockStatistics; }
+    void updateAutoWidth(double blockSeconds);
+
+    //Written once per block by the audio thread, read by the editor
+    std::atomic<float> meterPeak { 0.0f }, meterRMS { 0.0f }, meterSideToMid { 0.0f }, meterCorrelation { 0.0f };
+    std::atomic<juce::uint32> meterBlock { 0 };
+
+    void publishOutputLevels(const StereoMatrix::Statistics& statistics);
+
+    //Paths that skip the matrix pass measure what they hand back, so the meters never freeze
+    template<class sampleType>
+    void publishBufferLevels(const juce::AudioBuffer<sampleType>& buffer, bool isMS);
+
+    /** Auto rotation: tempo-synced LFO on Theta_r. Per-sample sin/cos come from the
+        quadrature oscillator and SineTable; LPFLink follows every modulationInterval. */
+    std::atomic<float>* autoRotate = nullptr;
+    std::atomic<float>* autoRotateRate = nullptr;
+    std::atomic<float>* autoRotateDepth = nullptr;
+    std::atomic<float>* autoRotateShape = nullptr;
+    std::atomic<float>* autoRotatePhase = nullptr;
+    static constexpr int modulationInterval = 32;
+
+    RotationLFO rotationLFO;
+    bool blockAutoRotate = false;
+
+    /** Transient-aware width: transients pull a widening width stage back to neutral,
+        so only the sustained part is widened. TransientDetector fills a curve per
+        block from the input and the matrix is blended towards neutral along it. */
+    std::atomic<float>* transientWidth = nullptr;
+    TransientDetector transientDetector;
+    bool blockTransient = false, transientActive = false;
+
+    template<class sampleType>
+    const float* getTransientCurve(const sampleType* first, const sampleType* second, int numSamples);
+    static StereoMatrix::WidthGains getTransientGains(const StereoMatrix::WidthGains& widthGains, double Theta_w, double gain);
+    StereoMatrix::Coefficients getCurrentTransientMatrix() const;
+
+    /** Sidechain modulation: the level of the optional sidechain bus pushes Width and
+        Rotation by up to their sidechain depths. SidechainEnvelope fills a curve at the
+        host rate and every quality offsets the width and rotation angles along it (per
+        sample, per Eco interval), see getPushedMatrix(). Nothing runs while the
+        bus is off or both depths are 0; binaural and AmbiX are not modulated. */
+    std::atomic<float>* sidechainWidth = nullptr;
+    std::atomic<float>* sidechainRotation = nullptr;
+    std::atomic<float>* sidechainThreshold = nullptr;
+    std::atomic<float>* sidechainAttack = nullptr;
+    std::atomic<float>* sidechainRelease = nullptr;
+    SidechainEnvelope sidechainEnvelope;
+    const float* sidechainCurve = nullptr;      //This block's amount at the host rate, or nullptr
+    bool sidechainActive = false;
+    double sidechainWidthOffset = 0.0, sidechainRotationOffset = 0.0;   //Theta_w / Theta_r added at full amount
+
+    template<class sampleType>
+    const float* getSidechainCurve(juce::AudioBuffer<sampleType>& buffer, bool isWidthBypass, bool isRotationBypass);
+    double getSidechainWidth(double Theta_w, double amount) const;
+    StereoMatrix::Coefficients getPushedMatrix(double Theta_w, double Theta_r, double outputGain,
+                                               double sidechainAmount, double transientAmount) const;
+
+    std::atomic<float>* binaural = nullptr;
+    bool binauralActive = false;
+    std::shared_ptr<const BinauralRenderer::HRIRSet> hrirSet;     //At the prepared rate, message thread
+    static constexpr const char* hrirPathProperty = "hrirpath";
+
+    std::shared_ptr<const PresetLibrary> presetLibrary;
+    static constexpr const char* presetLibraryProperty = "presetlibrary";
 
-    juce::dsp::IIR::Filter<double> LowPassL, LowPassR;
+    //Owned here so closing the editor does not cancel a running audit
+    std::unique_ptr<StereoFieldAnalyzer::BatchAudit> audit;
+
+    template<class sampleType>
+    void processBinaural(sampleType* leftChannel, sampleType* rightChannel, int numSamples);
+
+    /** First-order AmbiX buses: Rotation is yaw, Width balances W against X/Y/Z. */
+    std::atomic<float>* pitch = nullptr;
+    std::atomic<float>* roll = nullptr;
+    juce::SmoothedValue<double> smoothedPitch, smoothedRoll;
+    bool ambisonicLayout = false;
+
+    template<class sampleType>
+    void processAmbisonic(juce::AudioBuffer<sampleType>& buffer, bool isRotationBypass);
+
+    void syncRotationLFO(double sampleRate);
+    template<class sampleType>
+    void processModulated(sampleType* leftChannel, sampleType* rightChannel, int numSamples,
+                          double sampleRate, int controlInterval, bool useOnePole);
+
+    /** CPU/accuracy trade-off of the whole processing chain.
+        Eco updates parameters every ecoUpdateInterval samples and uses a one-pole LPFLink,
+        Standard ramps the matrix per block, High ramps the angles per sample in double
+        precision with LPFLink oversampled 2x. */
+    enum class Quality { eco = 0, standard, high };
+    Quality currentQuality = Quality::standard;
+    bool highBlockOverflow = false;     //A block outgrew the High buffers; Standard until the next prepareToPlay()
+    static constexpr int ecoUpdateInterval = 64;
+    static constexpr double smoothingTimeSeconds = 0.05;
+
+    juce::SmoothedValue<double> smoothedWidth, smoothedRotation, smoothedGain;
+
+    /** Everything sized or tuned for one ProcessSpec, the binaural renderer included.
+        prepareToPlay() (and loadHRIR()) builds a new one off the audio thread and
+        publishes it through pendingState; the audio
+        thread adopts it at the start of its next block with a pointer swap and hands
+        the old one back through retiredState, to be freed on the message thread. */
+    struct PreparedState
+    {
+        explicit PreparedState(const juce::dsp::ProcessSpec& processSpec);
+
+        juce::dsp::ProcessSpec spec;
+        bool ambisonicLayout = false;
+
+        //Both filters share one coefficient set; only one of them runs at a time
+        juce::dsp::IIR::Coefficients<double>::Ptr lowPassCoefficients;
+        juce::dsp::IIR::Filter<double> lowPassL, lowPassR;
+
+        //Scratch space for High quality; float buffers are processed through it in double
+        juce::dsp::Oversampling<double> oversampler;
+        juce::AudioBuffer<double> highPrecisionBuffer;
+
+        //Up to the 2x rate of High
+        std::vector<float> transientCurve;
+
+        //Host rate; High reads every value twice
+        std::vector<float> sidechainCurve;
+
+        //Convolution state for hrirSet at this rate; nullptr without an HRIR set
+        std::unique_ptr<BinauralRenderer> binauralRenderer;
+    };
+
+    PreparedState* preparedState = nullptr;     //Owned by the audio thread between prepareToPlay() and releaseResources()
+    std::atomic<PreparedState*> pendingState { nullptr };
+    std::atomic<PreparedState*> retiredState { nullptr };
+
+    //Spec of the last prepareToPlay(), so loading an HRIR set can build a state for it
+    juce::dsp::ProcessSpec preparedSpec {};
+    bool hasPreparedSpec = false;
+
+    std::unique_ptr<PreparedState> buildState(const juce::dsp::ProcessSpec& spec);
+    void publishState(std::unique_ptr<PreparedState> newState);
+    void adoptPendingState();
+    void freeRetiredState();
+    void freeAllStates();
+
+    double ecoLowPassStateL = 0.0, ecoLowPassStateR = 0.0;
+    double currentSampleRate = 44100.0;
+    int lastLPFSide = 0;
+    std::atomic<int> pendingLatency { 0 };
+
+    Quality getEffectiveQuality() const;
+    void setQuality(Quality newQuality);
+    static void retuneSmoothing(juce::SmoothedValue<double>& smoothed, double rampRate);
+    void updateLatency();
+    void handleAsyncUpdate() override;
+
+    StereoMatrix::Coefficients getCurrentMatrix() const;
+    int getLPFSide(double Theta_r) const;
+    double getLPFFrequency(double Theta_r) const;
+    void setLPFSide(int lpfSide);
+    void resetLowPass();
+    static double getOnePoleCoefficient(double frequency, double sampleRate);
+    void updateLowPassCoefficients(double sampleRate, double frequency, double Q);
+
+    template<class sampleType>
+    void processEco(sampleType* leftChannel, sampleType* rightChannel, int numSamples, int lpfSide, double frequency);
+    template<class sampleType>
+    void processStandard(sampleType* leftChannel, sampleType* rightChannel, int numSamples, int lpfSide, double frequency, double Q);
+    void processHigh(juce::AudioBuffer<float>& buffer, int lpfSide, double frequency, double Q);
+    void processHigh(juce::AudioBuffer<double>& buffer, int lpfSide, double frequency, double Q);
+    void processHighBlock(juce::dsp::AudioBlock<double> block, int lpfSide, double frequency, double Q);
 
     template<class sampleType>
     void processBlockWrapper(juce::AudioBuffer<sampleType>& buffer, juce::MidiBuffer& midiMessages);
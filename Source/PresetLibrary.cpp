@@ -0,0 +1,325 @@
+/*
+  ==============================================================================
+
+    PresetLibrary.cpp
+    Memory-mapped library of LPanner parameter snapshots.
+
+  ==============================================================================
+*/
+
+#include "PresetLibrary.h"
+#include <map>
+
+namespace
+{
+    const char magic[4] = { 'L', 'P', 'P', 'L' };
+    constexpr juce::uint32 version = 1;
+    constexpr size_t headerSize = 12 * 4;
+    constexpr size_t tagEntrySize = PresetLibrary::idSize + 8;
+
+    /** Reads a zero-padded UTF-8 field. */
+    juce::String readText(const char* text, int maxBytes)
+    {
+        int length = 0;
+        while (length < maxBytes && text[length] != 0) ++length;
+        return juce::String::fromUTF8(text, length);
+    }
+
+    /** Drops whole characters until text fits a zero-padded field of fieldBytes. */
+    juce::String fitText(const juce::String& text, int fieldBytes)
+    {
+        juce::String fitted = text;
+        while (fitted.getNumBytesAsUTF8() >= (size_t)fieldBytes)
+            fitted = fitted.dropLastCharacters(1);
+        return fitted;
+    }
+
+    /** Writes text that already went through fitText() into its zero-padded field. */
+    void writeText(juce::MemoryOutputStream& stream, const juce::String& fitted, int fieldBytes)
+    {
+        jassert(fitted.getNumBytesAsUTF8() < (size_t)fieldBytes);
+
+        const auto bytes = (int)fitted.getNumBytesAsUTF8();
+        stream.write(fitted.toRawUTF8(), (size_t)bytes);
+        stream.writeRepeatedByte(0, (size_t)(fieldBytes - bytes));
+    }
+}
+
+//==============================================================================
+std::shared_ptr<const PresetLibrary> PresetLibrary::open(const juce::File& file, juce::String& error)
+{
+    //Instances of the plugin share one mapping per file
+    static juce::CriticalSection cacheLock;
+    static std::map<juce::String, std::weak_ptr<const PresetLibrary>> cache;
+
+    const juce::ScopedLock sl(cacheLock);
+    const auto key = file.getFullPathName();
+    if (auto existing = cache[key].lock())
+        if (existing->modified == file.getLastModificationTime())
+            return existing;
+
+    std::shared_ptr<PresetLibrary> library(new PresetLibrary());
+    library->file = file;
+    library->modified = file.getLastModificationTime();
+    library->mapping.reset(new juce::MemoryMappedFile(file, juce::MemoryMappedFile::readOnly));
+    library->data = static_cast<const char*>(library->mapping->getData());
+    library->size = library->mapping->getSize();
+
+    auto& l = *library;
+    if (l.data == nullptr || l.size < headerSize || std::memcmp(l.data, magic, 4) != 0){
+        error = file.getFileName() + " is not an LPanner preset library";
+        return nullptr;
+    }
+    if (l.readUInt(4) != version){
+        error = file.getFileName() + " was written by an unsupported version";
+        return nullptr;
+    }
+
+    const auto numParameters = l.readUInt(8);
+    l.numPresets = (int)l.readUInt(12);
+    l.numTags = (int)l.readUInt(16);
+    l.hashSize = l.readUInt(20);
+    const size_t parameterOffset = l.readUInt(24);
+    l.tagOffset = l.readUInt(28);
+    l.tagIndexOffset = l.readUInt(32);
+    l.hashOffset = l.readUInt(36);
+    l.recordOffset = l.readUInt(40);
+    l.recordSize = l.readUInt(44);
+
+    //Every table has to lie inside the file before anything reads from it
+    auto fits = [&l](size_t offset, size_t bytes){ return offset <= l.size && bytes <= l.size - offset; };
+    const bool valid = l.numTags <= maxTags
+                    && l.hashSize > (juce::uint32)l.numPresets && juce::isPowerOfTwo(l.hashSize)
+                    && l.recordSize == (size_t)nameSize + 8 + numParameters * 4
+                    && fits(parameterOffset, (size_t)numParameters * idSize)
+                    && fits(l.tagOffset, (size_t)l.numTags * tagEntrySize)
+                    && fits(l.hashOffset, (size_t)l.hashSize * 4)
+                    && fits(l.recordOffset, (size_t)l.numPresets * l.recordSize);
+
+    //Each tag's slice of the index must lie in the file and name existing presets,
+    //since getPresetWithTag() hands them out unchecked
+    bool tagsValid = valid;
+    for (int tag = 0; tagsValid && tag < l.numTags; ++tag){
+        const size_t entry = l.tagOffset + (size_t)tag * tagEntrySize + idSize;
+        const size_t first = l.tagIndexOffset + (size_t)l.readUInt(entry) * 4;
+        const size_t count = l.readUInt(entry + 4);
+        tagsValid = fits(first, count * 4);
+
+        for (size_t n = 0; tagsValid && n < count; ++n)
+            tagsValid = l.readUInt(first + n * 4) < (juce::uint32)l.numPresets;
+    }
+
+    if (!tagsValid){
+        error = file.getFileName() + " is damaged";
+        return nullptr;
+    }
+
+    //The ID table is tiny; keeping it as strings makes applying a preset a plain loop
+    for (juce::uint32 parameter = 0; parameter < numParameters; ++parameter)
+        l.parameterIDs.add(readText(l.data + parameterOffset + parameter * idSize, idSize));
+
+    cache[key] = library;
+    return library;
+}
+
+//==============================================================================
+juce::uint32 PresetLibrary::readUInt(size_t offset) const
+{
+    return juce::ByteOrder::littleEndianInt(data + offset);
+}
+
+const char* PresetLibrary::getRecord(int preset) const
+{
+    jassert(juce::isPositiveAndBelow(preset, numPresets));
+    return data + recordOffset + (size_t)preset * recordSize;
+}
+
+juce::uint32 PresetLibrary::hashName(const juce::String& name)
+{
+    //FNV-1a over the lower-case UTF-8 bytes
+    const auto lower = name.toLowerCase();
+    juce::uint32 hash = 2166136261u;
+    for (auto* c = lower.toRawUTF8(); *c != 0; ++c){
+        hash ^= (juce::uint8)*c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+juce::String PresetLibrary::getName(int preset) const
+{
+    return readText(getRecord(preset), nameSize);
+}
+
+int PresetLibrary::findByName(const juce::String& name) const
+{
+    //Records hold the name cut to its field, and the hash was taken of that
+    const auto stored = fitText(name, nameSize);
+    const juce::uint32 mask = hashSize - 1;
+    for (juce::uint32 slot = hashName(stored) & mask, probes = 0; probes < hashSize; slot = (slot + 1) & mask, ++probes){
+        const juce::uint32 entry = readUInt(hashOffset + slot * 4);
+        if (entry == 0 || entry > (juce::uint32)numPresets) return -1;
+        if (getName((int)entry - 1).equalsIgnoreCase(stored)) return (int)entry - 1;
+    }
+    return -1;
+}
+
+juce::Array<int> PresetLibrary::search(const juce::String& text) const
+{
+    juce::Array<int> matches;
+    for (int preset = 0; preset < numPresets; ++preset)
+        if (getName(preset).containsIgnoreCase(text))
+            matches.add(preset);
+    return matches;
+}
+
+juce::String PresetLibrary::getTagName(int tag) const
+{
+    return readText(data + tagOffset + (size_t)tag * tagEntrySize, idSize);
+}
+
+int PresetLibrary::findTag(const juce::String& name) const
+{
+    const auto stored = fitText(name, idSize);
+    for (int tag = 0; tag < numTags; ++tag)
+        if (getTagName(tag).equalsIgnoreCase(stored))
+            return tag;
+    return -1;
+}
+
+int PresetLibrary::getNumPresetsWithTag(int tag) const
+{
+    return (int)readUInt(tagOffset + (size_t)tag * tagEntrySize + idSize + 4);
+}
+
+int PresetLibrary::getPresetWithTag(int tag, int n) const
+{
+    const juce::uint32 first = readUInt(tagOffset + (size_t)tag * tagEntrySize + idSize);
+    return (int)readUInt(tagIndexOffset + ((size_t)first + n) * 4);
+}
+
+bool PresetLibrary::hasTag(int preset, int tag) const
+{
+    const char* record = getRecord(preset);
+    const juce::uint32 word = juce::ByteOrder::littleEndianInt(record + nameSize + (tag < 32 ? 0 : 4));
+    return ((word >> (tag % 32)) & 1) != 0;
+}
+
+float PresetLibrary::getValue(int preset, int parameter) const
+{
+    const juce::uint32 bits = juce::ByteOrder::littleEndianInt(getRecord(preset) + nameSize + 8 + (size_t)parameter * 4);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//==============================================================================
+PresetLibrary::Entry PresetLibrary::makeEntry(const juce::String& name, const juce::StringArray& tags,
+                                              const juce::XmlElement& state, const juce::StringArray& parameterIDs)
+{
+    Entry entry;
+    entry.name = name;
+    entry.tags = tags;
+    entry.values.assign((size_t)parameterIDs.size(), 0.0f);
+
+    //AudioProcessorValueTreeState writes one PARAM child per parameter
+    for (auto* param = state.getChildByName("PARAM"); param != nullptr; param = param->getNextElementWithTagName("PARAM")){
+        const int index = parameterIDs.indexOf(param->getStringAttribute("id"));
+        if (index >= 0)
+            entry.values[(size_t)index] = (float)param->getDoubleAttribute("value");
+    }
+
+    return entry;
+}
+
+juce::String PresetLibrary::write(const juce::File& destination, const juce::StringArray& parameterIDs, const std::vector<Entry>& entries)
+{
+    //Names and tags are cut to their fields once, so the hash and the records agree
+    juce::StringArray names, tagNames;
+    for (const auto& entry : entries){
+        names.add(fitText(entry.name, nameSize));
+        for (const auto& tag : entry.tags)
+            tagNames.addIfNotAlreadyThere(fitText(tag, idSize), true);
+    }
+
+    if (tagNames.size() > maxTags)
+        return "A library holds at most " + juce::String(maxTags) + " tags";
+
+    const auto numParameters = (juce::uint32)parameterIDs.size();
+    const auto numPresets = (juce::uint32)entries.size();
+    const auto numTags = (juce::uint32)tagNames.size();
+
+    juce::uint32 hashSize = 16;
+    while (hashSize < numPresets * 2) hashSize *= 2;
+
+    //Tag index: preset indices grouped by tag
+    std::vector<std::vector<juce::uint32>> presetsByTag(numTags);
+    std::vector<juce::uint64> tagMasks(numPresets, 0);
+    for (juce::uint32 preset = 0; preset < numPresets; ++preset){
+        for (const auto& tag : entries[preset].tags){
+            const int index = tagNames.indexOf(fitText(tag, idSize), true);
+            if (index < 0 || (tagMasks[preset] >> index & 1) != 0) continue;
+            presetsByTag[(size_t)index].push_back(preset);
+            tagMasks[preset] |= (juce::uint64)1 << index;
+        }
+    }
+
+    juce::uint32 tagIndexCount = 0;
+    for (const auto& presets : presetsByTag)
+        tagIndexCount += (juce::uint32)presets.size();
+
+    //Name hash, open addressing
+    std::vector<juce::uint32> hash(hashSize, 0);
+    for (juce::uint32 preset = 0; preset < numPresets; ++preset){
+        juce::uint32 slot = hashName(names[(int)preset]) & (hashSize - 1);
+        while (hash[slot] != 0) slot = (slot + 1) & (hashSize - 1);
+        hash[slot] = preset + 1;
+    }
+
+    const juce::uint32 parameterOffset = (juce::uint32)headerSize;
+    const juce::uint32 tagOffset = parameterOffset + numParameters * idSize;
+    const juce::uint32 tagIndexOffset = tagOffset + numTags * (juce::uint32)tagEntrySize;
+    const juce::uint32 hashOffset = tagIndexOffset + tagIndexCount * 4;
+    const juce::uint32 recordOffset = hashOffset + hashSize * 4;
+    const juce::uint32 recordSize = nameSize + 8 + numParameters * 4;
+
+    juce::MemoryOutputStream stream;
+    stream.write(magic, 4);
+    for (auto value : { version, numParameters, numPresets, numTags, hashSize,
+                        parameterOffset, tagOffset, tagIndexOffset, hashOffset, recordOffset, recordSize })
+        stream.writeInt((int)value);
+
+    for (const auto& id : parameterIDs)
+        writeText(stream, fitText(id, idSize), idSize);
+
+    juce::uint32 first = 0;
+    for (juce::uint32 tag = 0; tag < numTags; ++tag){
+        writeText(stream, tagNames[(int)tag], idSize);
+        stream.writeInt((int)first);
+        stream.writeInt((int)presetsByTag[tag].size());
+        first += (juce::uint32)presetsByTag[tag].size();
+    }
+
+    for (const auto& presets : presetsByTag)
+        for (auto preset : presets)
+            stream.writeInt((int)preset);
+
+    for (auto slot : hash)
+        stream.writeInt((int)slot);
+
+    for (juce::uint32 preset = 0; preset < numPresets; ++preset){
+        const auto& entry = entries[preset];
+        writeText(stream, names[(int)preset], nameSize);
+        stream.writeInt64((juce::int64)tagMasks[preset]);
+
+        for (juce::uint32 parameter = 0; parameter < numParameters; ++parameter)
+            stream.writeFloat(parameter < entry.values.size() ? entry.values[parameter] : 0.0f);
+    }
+
+    jassert(stream.getDataSize() == recordOffset + (size_t)numPresets * recordSize);
+
+    if (!destination.replaceWithData(stream.getData(), stream.getDataSize()))
+        return "Cannot write " + destination.getFullPathName();
+
+    return {};
+}
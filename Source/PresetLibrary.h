@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    PresetLibrary.h
+    Memory-mapped library of LPanner parameter snapshots.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/** Read-only preset library in a fixed little-endian binary layout, memory-mapped
+    so nothing is parsed on load and lookups read straight from the mapping.
+
+    Layout, every field 32-bit unless noted:
+
+        header      magic "LPPL", version, numParameters, numPresets, numTags, hashSize,
+                    parameterOffset, tagOffset, tagIndexOffset, hashOffset, recordOffset, recordSize
+        parameters  numParameters x char[32] parameter IDs
+        tags        numTags x { char[32] name, first, count } into the tag index
+        tag index   preset indices grouped by tag
+        hash        hashSize slots of preset index + 1 (0 = empty), open addressing on
+                    FNV-1a of the lower-case name
+        records     numPresets x { char[64] name, tag mask (64 bit), float values[numParameters] }
+
+    One mapping per file is shared by every instance in the process (see open()).
+*/
+class PresetLibrary
+{
+public:
+    static constexpr int nameSize = 64;
+    static constexpr int idSize = 32;
+    static constexpr int maxTags = 64;
+
+    /** Opens a library, reusing the mapping if another instance already has it.
+        Returns nullptr and sets error if the file is missing or malformed. */
+    static std::shared_ptr<const PresetLibrary> open(const juce::File& file, juce::String& error);
+
+    //==============================================================================
+    juce::File getFile() const { return file; }
+
+    int getNumPresets() const { return numPresets; }
+    juce::String getName(int preset) const;
+
+    /** Exact, case-insensitive name lookup through the hash table; -1 if absent. */
+    int findByName(const juce::String& name) const;
+
+    /** Presets whose name contains text, in library order. */
+    juce::Array<int> search(const juce::String& text) const;
+
+    int getNumTags() const { return numTags; }
+    juce::String getTagName(int tag) const;
+    int findTag(const juce::String& name) const;
+    int getNumPresetsWithTag(int tag) const;
+    int getPresetWithTag(int tag, int n) const;
+    bool hasTag(int preset, int tag) const;
+
+    int getNumParameters() const { return parameterIDs.size(); }
+    const juce::String& getParameterID(int parameter) const { return parameterIDs.getReference(parameter); }
+    float getValue(int preset, int parameter) const;
+
+    //==============================================================================
+    struct Entry
+    {
+        juce::String name;
+        juce::StringArray tags;
+        std::vector<float> values;      //One per parameter ID, plain (not normalised) values
+    };
+
+    /** Takes the PARAM values of a state written by getStateInformation(). */
+    static Entry makeEntry(const juce::String& name, const juce::StringArray& tags,
+                           const juce::XmlElement& state, const juce::StringArray& parameterIDs);
+
+    /** Writes a library; returns an error or an empty string. */
+    static juce::String write(const juce::File& destination, const juce::StringArray& parameterIDs, const std::vector<Entry>& entries);
+
+private:
+    PresetLibrary() = default;
+
+    static juce::uint32 hashName(const juce::String& name);
+    juce::uint32 readUInt(size_t offset) const;
+    const char* getRecord(int preset) const;
+
+    juce::File file;
+    juce::Time modified;        //A rewritten file gets a fresh mapping instead of the cached one
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    const char* data = nullptr;
+    size_t size = 0;
+
+    int numPresets = 0, numTags = 0;
+    juce::uint32 hashSize = 0;
+    size_t tagOffset = 0, tagIndexOffset = 0, hashOffset = 0, recordOffset = 0, recordSize = 0;
+    juce::StringArray parameterIDs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetLibrary)
+};
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    RefreshScheduler.h
+    One refresh clock shared by every open LPanner editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Drives all animated editor parts from a single message-thread timer instead of
+    one timer per component, shared through juce::SharedResourcePointer.
+
+    Each frame it walks the registered clients round-robin, skips those that are
+    not on screen, asks the rest whether their data changed and repaints only those,
+    up to maxRepaintsPerFrame. Clients over budget are served first next frame.
+    Message thread only.
+*/
+class RefreshScheduler  : private juce::Timer
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /** Component repainted when updateForRefresh() reports a change. */
+        virtual juce::Component& getRefreshComponent() = 0;
+
+        /** Pulls the latest data; returns true if the component needs repainting. */
+        virtual bool updateForRefresh() = 0;
+    };
+
+    RefreshScheduler() = default;
+
+    ~RefreshScheduler() override
+    {
+        stopTimer();
+    }
+
+    void addClient(Client* client)
+    {
+        clients.addIfNotAlreadyThere(client);
+        if (!isTimerRunning())
+            startTimerHz(frameRate);
+    }
+
+    void removeClient(Client* client)
+    {
+        const int index = clients.indexOf(client);
+        if (index < 0) return;
+
+        clients.remove(index);
+        if (index < nextClient) --nextClient;
+
+        if (clients.isEmpty())
+            stopTimer();
+    }
+
+private:
+    void timerCallback() override
+    {
+        const int numClients = clients.size();
+        if (numClients == 0) return;
+
+        int repaints = 0;
+        for (int visited = 0; visited < numClients && repaints < maxRepaintsPerFrame; ++visited){
+            if (nextClient >= numClients) nextClient = 0;
+            auto* client = clients.getUnchecked(nextClient++);
+
+            auto& component = client->getRefreshComponent();
+            if (!component.isShowing()) continue;
+
+            if (client->updateForRefresh()){
+                component.repaint();
+                ++repaints;
+            }
+        }
+    }
+
+    static constexpr int frameRate = 60;
+    static constexpr int maxRepaintsPerFrame = 24;
+
+    juce::Array<Client*> clients;
+    int nextClient = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(RefreshScheduler)
+};
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    RotationLFO.h
+    Tempo-synced modulation source for auto rotation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "cmath"
+#include "corecrt_math_defines.h"
+
+//==============================================================================
+/** Sine table with linear interpolation, for per-sample sin/cos of the modulated
+    rotation angle without calling std::sin/std::cos. One read-only table is
+    shared by every instance.
+*/
+class SineTable
+{
+public:
+    static const SineTable& getInstance()
+    {
+        static const SineTable instance;
+        return instance;
+    }
+
+    double sin(double angle) const
+    {
+        double position = angle * (size / (2.0 * M_PI));
+        position -= std::floor(position / size) * size;
+
+        const int index = juce::jmin((int)position, size - 1);
+        const double fraction = position - index;
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    double cos(double angle) const
+    {
+        return sin(angle + M_PI / 2);
+    }
+
+private:
+    SineTable()
+    {
+        for (int i = 0; i <= size; ++i)
+            table[i] = std::sin(2.0 * M_PI * i / size);
+    }
+
+    static constexpr int size = 1024;
+    double table[size + 1];
+};
+
+//==============================================================================
+/** Recursive quadrature oscillator plus a triangle shape, resynced to the host
+    phase once per block so it never drifts.
+*/
+class RotationLFO
+{
+public:
+    enum class Shape { sine = 0, triangle };
+
+    /** Starts a block at phase (in cycles) advancing by increment cycles per sample. */
+    void sync(double phase, double increment, Shape newShape)
+    {
+        currentPhase = phase - std::floor(phase);
+        phaseIncrement = increment;
+        shape = newShape;
+
+        sinValue = std::sin(2.0 * M_PI * currentPhase);
+        cosValue = std::cos(2.0 * M_PI * currentPhase);
+        sinDelta = std::sin(2.0 * M_PI * increment);
+        cosDelta = std::cos(2.0 * M_PI * increment);
+    }
+
+    /** Current value in [-1, 1], then advances one sample. */
+    double next()
+    {
+        double value;
+        if (shape == Shape::sine){
+            value = sinValue;
+        }
+        else{
+            //Triangle in phase with the sine: 0 at phase 0, 1 at phase 0.25
+            double shifted = currentPhase + 0.25;
+            value = 1.0 - 4.0 * std::abs(shifted - std::floor(shifted) - 0.5);
+        }
+
+        const double nextSin = sinValue * cosDelta + cosValue * sinDelta;
+        cosValue = cosValue * cosDelta - sinValue * sinDelta;
+        sinValue = nextSin;
+
+        currentPhase += phaseIncrement;
+        if (currentPhase >= 1.0) currentPhase -= 1.0;
+
+        return value;
+    }
+
+    /** Phase (in cycles) of the next sample, to continue free-running across blocks. */
+    double getPhase() const { return currentPhase; }
+
+private:
+    Shape shape = Shape::sine;
+    double currentPhase = 0.0, phaseIncrement = 0.0;
+    double sinValue = 0.0, cosValue = 1.0;
+    double sinDelta = 0.0, cosDelta = 1.0;
+};
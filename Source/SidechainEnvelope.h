@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    SidechainEnvelope.h
+    Modulation amount from the level of the sidechain bus.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "cmath"
+
+//==============================================================================
+/** Peak envelope of the sidechain mapped to a modulation amount (0..1): 0 below
+    the threshold, 1 from rangeRatio above it, linear in amplitude in between.
+
+    Runs in three passes over the curve buffer so that only the follower itself is
+    sequential: rectify and take the louder channel, follow with attack/release,
+    then map to the amount. The first and last are plain element-wise loops the
+    compiler vectorizes.
+*/
+class SidechainEnvelope
+{
+public:
+    /** Attack and release in seconds; cheap enough to call every block. */
+    void setTimes(double attackSeconds, double releaseSeconds, double sampleRate)
+    {
+        attack = (float)getCoefficient(attackSeconds, sampleRate);
+        release = (float)getCoefficient(releaseSeconds, sampleRate);
+    }
+
+    void reset()
+    {
+        envelope = 0.0f;
+    }
+
+    /** Writes the amount for every sample of the sidechain channels into curve. */
+    template <class sampleType>
+    void process(const sampleType* const* channels, int numChannels, int numSamples, float thresholdGain, float* curve)
+    {
+        //Rectify; a mono sidechain reads its only channel twice
+        const sampleType* first = channels[0];
+        const sampleType* second = channels[numChannels > 1 ? 1 : 0];
+        for (int i = 0; i < numSamples; ++i)
+            curve[i] = (float)juce::jmax(std::abs(first[i]), std::abs(second[i]));
+
+        //Follower, in place
+        float value = envelope;
+        for (int i = 0; i < numSamples; ++i){
+            const float input = curve[i];
+            value += (input > value ? attack : release) * (input - value);
+            curve[i] = value;
+        }
+        envelope = value;
+
+        //Mapping
+        const float offset = thresholdGain;
+        const float scale = 1.0f / (thresholdGain * (rangeRatio - 1.0f));
+        for (int i = 0; i < numSamples; ++i)
+            curve[i] = juce::jlimit(0.0f, 1.0f, (curve[i] - offset) * scale);
+    }
+
+    static constexpr float rangeRatio = 16.0f;     //+24 dB from threshold to full modulation
+
+private:
+    static double getCoefficient(double seconds, double sampleRate)
+    {
+        return 1.0 - std::exp(-1.0 / (juce::jmax(seconds, 1.0e-5) * sampleRate));
+    }
+
+    float envelope = 0.0f;
+    float attack = 1.0f, release = 1.0f;
+};
@@ -0,0 +1,369 @@
+/*
+  ==============================================================================
+
+    StereoFieldAnalyzer.cpp
+    Offline stereo width / mono compatibility audit of audio files.
+
+  ==============================================================================
+*/
+
+#include "StereoFieldAnalyzer.h"
+#include "cmath"
+#include "corecrt_math_defines.h"
+
+namespace StereoFieldAnalyzer
+{
+//==============================================================================
+void Sums::add(const float* left, const float* right, int num)
+{
+    //Four independent accumulators per sum so the loop has no serial dependency
+    double ll[4] = {}, rr[4] = {}, lr[4] = {};
+
+    int i = 0;
+    for (; i + 4 <= num; i += 4){
+        for (int lane = 0; lane < 4; ++lane){
+            const double l = left[i + lane], r = right[i + lane];
+            ll[lane] += l * l;
+            rr[lane] += r * r;
+            lr[lane] += l * r;
+        }
+    }
+    for (; i < num; ++i){
+        const double l = left[i], r = right[i];
+        ll[0] += l * l;
+        rr[0] += r * r;
+        lr[0] += l * r;
+    }
+
+    leftEnergy += (ll[0] + ll[1]) + (ll[2] + ll[3]);
+    rightEnergy += (rr[0] + rr[1]) + (rr[2] + rr[3]);
+    leftRight += (lr[0] + lr[1]) + (lr[2] + lr[3]);
+
+    const auto leftRange = juce::FloatVectorOperations::findMinAndMax(left, num);
+    const auto rightRange = juce::FloatVectorOperations::findMinAndMax(right, num);
+    peak = juce::jmax(peak, -leftRange.getStart(), leftRange.getEnd(), -rightRange.getStart());
+    peak = juce::jmax(peak, rightRange.getEnd());
+
+    numSamples += num;
+}
+
+void Sums::add(const Sums& other)
+{
+    leftEnergy += other.leftEnergy;
+    rightEnergy += other.rightEnergy;
+    leftRight += other.leftRight;
+    peak = juce::jmax(peak, other.peak);
+    numSamples += other.numSamples;
+}
+
+double Sums::getCorrelation() const
+{
+    const double denominator = std::sqrt(leftEnergy * rightEnergy);
+    return denominator > 1.0e-12 ? leftRight / denominator : 0.0;
+}
+
+double Sums::getSideToMidRatio() const
+{
+    //M = (L + R) / 2, S = (L - R) / 2; the common 1/4 cancels
+    const double midEnergy = leftEnergy + rightEnergy + 2.0 * leftRight;
+    const double sideEnergy = leftEnergy + rightEnergy - 2.0 * leftRight;
+    return midEnergy > 1.0e-12 ? sideEnergy / midEnergy : 0.0;
+}
+
+double Sums::getBalanceDecibels() const
+{
+    if (leftEnergy < 1.0e-12 && rightEnergy < 1.0e-12) return 0.0;
+    return 10.0 * std::log10(juce::jmax(leftEnergy, 1.0e-12) / juce::jmax(rightEnergy, 1.0e-12));
+}
+
+double Sums::getCentringRotation() const
+{
+    //After rotating by Theta_r, L'^2 - R'^2 is proportional to
+    //sin(2 Theta_r) (Em - Es) / 2 + cos(2 Theta_r) Ems, which vanishes at:
+    const double midEnergy = leftEnergy + rightEnergy + 2.0 * leftRight;
+    const double sideEnergy = leftEnergy + rightEnergy - 2.0 * leftRight;
+    const double midSide = leftEnergy - rightEnergy;
+    if (midEnergy + sideEnergy < 1.0e-12) return 0.0;
+
+    const double Theta_r = 0.5 * std::atan2(-2.0 * midSide, midEnergy - sideEnergy);
+
+    //Theta_r = -pi / 400 * rotation
+    return juce::jlimit(-100.0, 100.0, -Theta_r * 400.0 / M_PI);
+}
+
+double Sums::getNarrowingWidth(double targetSideMid) const
+{
+    const double ratio = getSideToMidRatio();
+    if (ratio <= targetSideMid || targetSideMid <= 0.0) return 50.0;
+
+    //Side/mid gain ratio of the width stage is cot(pi / 4 - Theta_w)
+    const double Theta_w = M_PI / 4 - std::atan(std::sqrt(ratio / targetSideMid));
+
+    //Theta_w = pi / 200 * (width - 50)
+    return juce::jlimit(0.0, 50.0, Theta_w * 200.0 / M_PI + 50.0);
+}
+
+//==============================================================================
+FileReport analyseFile(const juce::File& file, juce::AudioFormatManager& formatManager, const Settings& settings,
+                       const std::function<bool()>& shouldExit)
+{
+    FileReport report;
+    report.file = file;
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr){
+        report.error = "Cannot read file";
+        return report;
+    }
+
+    report.sampleRate = reader->sampleRate;
+    const juce::int64 length = reader->lengthInSamples;
+    const juce::int64 sectionLength = juce::jmax<juce::int64>(1, (juce::int64)(settings.sectionSeconds * reader->sampleRate));
+    const int blockSize = juce::jmax(1024, settings.blockSize);
+
+    //Mono readers fill both channels, so mono files read as L = R
+    juce::AudioBuffer<float> block(2, blockSize);
+    Section section;
+
+    for (juce::int64 position = 0; position < length; ){
+        //Long files must not hold up a shutdown
+        if (shouldExit != nullptr && shouldExit()){
+            report.error = "Cancelled";
+            return report;
+        }
+
+        const int num = (int)juce::jmin<juce::int64>(blockSize, length - position);
+        if (!reader->read(&block, 0, num, position, true, true)){
+            report.error = "Read error at sample " + juce::String(position);
+            break;
+        }
+
+        //Split the chunk at section boundaries
+        for (int offset = 0; offset < num; ){
+            const juce::int64 absolute = position + offset;
+            const juce::int64 sectionEnd = (absolute / sectionLength + 1) * sectionLength;
+            const int count = (int)juce::jmin<juce::int64>(num - offset, sectionEnd - absolute);
+
+            if (section.sums.numSamples == 0)
+                section.startSeconds = absolute / reader->sampleRate;
+
+            section.sums.add(block.getReadPointer(0, offset), block.getReadPointer(1, offset), count);
+            offset += count;
+
+            if (absolute + count == sectionEnd){
+                section.endSeconds = (absolute + count) / reader->sampleRate;
+                report.total.add(section.sums);
+                report.sections.push_back(section);
+                section = Section();
+            }
+        }
+
+        position += num;
+    }
+
+    if (section.sums.numSamples > 0){
+        section.endSeconds = section.startSeconds + section.sums.numSamples / reader->sampleRate;
+        report.total.add(section.sums);
+        report.sections.push_back(section);
+    }
+
+    return report;
+}
+
+juce::Array<juce::File> findAudioFiles(const juce::File& folder, juce::AudioFormatManager& formatManager,
+                                       const std::function<bool()>& shouldExit)
+{
+    //Walked by hand so a deep folder can be abandoned too
+    juce::Array<juce::File> files;
+    for (const auto& entry : juce::RangedDirectoryIterator(folder, true, formatManager.getWildcardForAllFormats(), juce::File::findFiles)){
+        if (shouldExit != nullptr && shouldExit()) break;
+        files.add(entry.getFile());
+    }
+    files.sort();
+    return files;
+}
+
+std::vector<FileReport> analyseFiles(const juce::Array<juce::File>& files, const Settings& settings,
+                                     std::atomic<int>& filesDone, std::function<bool()> shouldExit, int numThreads)
+{
+    std::vector<FileReport> reports((size_t)files.size());
+    if (files.isEmpty()) return reports;
+
+    if (numThreads <= 0)
+        numThreads = juce::SystemStats::getNumCpus();
+
+    std::atomic<int> remaining { files.size() };
+    juce::WaitableEvent finished;
+
+    //Declared last so its destructor waits for the jobs before the above go away
+    juce::ThreadPool pool(juce::jmin(numThreads, files.size()));
+
+    for (int index = 0; index < files.size(); ++index){
+        pool.addJob([&, index]{
+            if (shouldExit == nullptr || !shouldExit()){
+                //Format managers are cheap and not shared between threads
+                juce::AudioFormatManager formatManager;
+                formatManager.registerBasicFormats();
+                reports[(size_t)index] = analyseFile(files.getReference(index), formatManager, settings, shouldExit);
+            }
+            else{
+                reports[(size_t)index].file = files.getReference(index);
+                reports[(size_t)index].error = "Cancelled";
+            }
+
+            ++filesDone;
+            if (--remaining == 0)
+                finished.signal();
+        });
+    }
+
+    finished.wait();
+    return reports;
+}
+
+//==============================================================================
+namespace
+{
+    juce::String formatNumber(double value, int decimals)
+    {
+        return juce::String(value, decimals);
+    }
+
+    juce::String quoteCSV(const juce::String& text)
+    {
+        return "\"" + text.replace("\"", "\"\"") + "\"";
+    }
+
+    juce::String csvRow(const juce::String& name, const juce::String& section, double start, double end,
+                        const Sums& sums, const Settings& settings)
+    {
+        juce::StringArray fields;
+        fields.add(quoteCSV(name));
+        fields.add(section);
+        fields.add(formatNumber(start, 3));
+        fields.add(formatNumber(end, 3));
+        fields.add(formatNumber(sums.getCorrelation(), 4));
+        fields.add(formatNumber(sums.getSideToMidRatio(), 4));
+        fields.add(formatNumber(sums.getBalanceDecibels(), 2));
+        fields.add(formatNumber(juce::Decibels::gainToDecibels(sums.peak), 2));
+        fields.add(formatNumber(sums.getCentringRotation(), 1));
+        fields.add(formatNumber(sums.getNarrowingWidth(settings.targetSideMid), 1));
+        return fields.joinIntoString(",");
+    }
+
+    juce::var toVar(const Sums& sums, const Settings& settings)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("correlation", sums.getCorrelation());
+        object->setProperty("sideMidRatio", sums.getSideToMidRatio());
+        object->setProperty("balanceDb", sums.getBalanceDecibels());
+        object->setProperty("peakDb", juce::Decibels::gainToDecibels(sums.peak));
+        object->setProperty("centringRotation", sums.getCentringRotation());
+        object->setProperty("narrowingWidth", sums.getNarrowingWidth(settings.targetSideMid));
+        return juce::var(object);
+    }
+}
+
+bool writeCSV(const std::vector<FileReport>& reports, const Settings& settings, const juce::File& destination)
+{
+    juce::StringArray lines;
+    lines.add("file,section,start_s,end_s,correlation,side_mid_ratio,balance_db,peak_db,centring_rotation,narrowing_width");
+
+    for (const auto& report : reports){
+        const juce::String name = report.file.getFullPathName();
+        if (report.error.isNotEmpty()){
+            lines.add(quoteCSV(name) + ",error,,,,,,,," + quoteCSV(report.error));
+            continue;
+        }
+
+        const double duration = report.total.numSamples / juce::jmax(1.0, report.sampleRate);
+        lines.add(csvRow(name, "all", 0.0, duration, report.total, settings));
+
+        for (size_t index = 0; index < report.sections.size(); ++index){
+            const auto& section = report.sections[index];
+            lines.add(csvRow(name, juce::String((int)index + 1), section.startSeconds, section.endSeconds, section.sums, settings));
+        }
+    }
+
+    return destination.replaceWithText(lines.joinIntoString("\n") + "\n");
+}
+
+bool writeJSON(const std::vector<FileReport>& reports, const Settings& settings, const juce::File& destination)
+{
+    juce::Array<juce::var> files;
+
+    for (const auto& report : reports){
+        auto* object = new juce::DynamicObject();
+        object->setProperty("file", report.file.getFullPathName());
+
+        if (report.error.isNotEmpty()){
+            object->setProperty("error", report.error);
+        }
+        else{
+            object->setProperty("sampleRate", report.sampleRate);
+            object->setProperty("seconds", report.total.numSamples / juce::jmax(1.0, report.sampleRate));
+            object->setProperty("overall", toVar(report.total, settings));
+
+            juce::Array<juce::var> sections;
+            for (const auto& section : report.sections){
+                juce::var entry = toVar(section.sums, settings);
+                entry.getDynamicObject()->setProperty("start", section.startSeconds);
+                entry.getDynamicObject()->setProperty("end", section.endSeconds);
+                sections.add(entry);
+            }
+            object->setProperty("sections", sections);
+        }
+
+        files.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("sectionSeconds", settings.sectionSeconds);
+    root->setProperty("targetSideMid", settings.targetSideMid);
+    root->setProperty("files", files);
+
+    return destination.replaceWithText(juce::JSON::toString(juce::var(root)));
+}
+
+//==============================================================================
+BatchAudit::BatchAudit(const juce::File& f, const Settings& s, std::function<void(const juce::String&)> callback)
+    : juce::Thread("LPanner audit"), folder(f), settings(s), onFinished(std::move(callback))
+{
+    startThread(3);
+}
+
+BatchAudit::~BatchAudit()
+{
+    stopThread(10000);
+}
+
+void BatchAudit::run()
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    const auto files = findAudioFiles(folder, formatManager, [this]{ return threadShouldExit(); });
+    if (threadShouldExit()) return;
+    numFiles.store(files.size());
+
+    const auto reports = analyseFiles(files, settings, filesDone, [this]{ return threadShouldExit(); });
+    if (threadShouldExit()) return;
+
+    const bool written = writeCSV(reports, settings, folder.getChildFile(csvFileName))
+                      && writeJSON(reports, settings, folder.getChildFile(jsonFileName));
+
+    int failed = 0;
+    for (const auto& report : reports)
+        if (report.error.isNotEmpty()) ++failed;
+
+    juce::String summary = written ? "Audited " + juce::String(files.size() - failed) + " files into " + folder.getFullPathName()
+                                   : "Could not write the report into " + folder.getFullPathName();
+    if (failed > 0)
+        summary << " (" << failed << " unreadable)";
+
+    auto callback = onFinished;
+    juce::MessageManager::callAsync([callback, summary]{
+        if (callback != nullptr) callback(summary);
+    });
+}
+}
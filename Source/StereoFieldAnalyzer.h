@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    StereoFieldAnalyzer.h
+    Offline stereo width / mono compatibility audit of audio files.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+namespace StereoFieldAnalyzer
+{
+    //==============================================================================
+    /** Energy sums of an L/R signal; everything in the report derives from these. */
+    struct Sums
+    {
+        double leftEnergy = 0.0;
+        double rightEnergy = 0.0;
+        double leftRight = 0.0;
+        float peak = 0.0f;
+        juce::int64 numSamples = 0;
+
+        /** Adds one stretch of samples, reduced in four independent lanes. */
+        void add(const float* left, const float* right, int num);
+        void add(const Sums& other);
+
+        double getCorrelation() const;
+        double getSideToMidRatio() const;
+        /** Left over right energy in dB; positive leans left. */
+        double getBalanceDecibels() const;
+
+        /** Rotation parameter (-100..100) that balances L and R energy. */
+        double getCentringRotation() const;
+        /** Width parameter (0..100) that brings side/mid down to targetSideMid; 50 if already narrower. */
+        double getNarrowingWidth(double targetSideMid) const;
+    };
+
+    struct Section
+    {
+        double startSeconds = 0.0;
+        double endSeconds = 0.0;
+        Sums sums;
+    };
+
+    struct FileReport
+    {
+        juce::File file;
+        juce::String error;
+        double sampleRate = 0.0;
+        Sums total;
+        std::vector<Section> sections;
+    };
+
+    struct Settings
+    {
+        double sectionSeconds = 10.0;
+        double targetSideMid = 0.25;
+        int blockSize = 65536;      //Samples read per chunk; bounds memory per file
+    };
+
+    //==============================================================================
+    /** Streams one file through the reductions. Mono files are analysed as L = R.
+        shouldExit(), if given, is polled before every chunk; the report then ends as "Cancelled". */
+    FileReport analyseFile(const juce::File& file, juce::AudioFormatManager& formatManager, const Settings& settings,
+                           const std::function<bool()>& shouldExit = nullptr);
+
+    /** Every file below folder that formatManager can read, sorted. shouldExit(), if
+        given, is polled per entry; the list then stops where the walk did. */
+    juce::Array<juce::File> findAudioFiles(const juce::File& folder, juce::AudioFormatManager& formatManager,
+                                           const std::function<bool()>& shouldExit = nullptr);
+
+    /** Analyses files in parallel on a pool of numThreads (all cores when 0); blocks.
+        filesDone is bumped as files complete; shouldExit() is polled between chunks. */
+    std::vector<FileReport> analyseFiles(const juce::Array<juce::File>& files, const Settings& settings,
+                                         std::atomic<int>& filesDone, std::function<bool()> shouldExit, int numThreads = 0);
+
+    /** Default report names, written into the audited folder. */
+    static constexpr const char* csvFileName = "LPanner-audit.csv";
+    static constexpr const char* jsonFileName = "LPanner-audit.json";
+
+    bool writeCSV(const std::vector<FileReport>& reports, const Settings& settings, const juce::File& destination);
+    bool writeJSON(const std::vector<FileReport>& reports, const Settings& settings, const juce::File& destination);
+
+    //==============================================================================
+    /** Audits every audio file below a folder on a background thread and writes
+        csvFileName / jsonFileName into it. onFinished is called on the message thread
+        with a one-line summary. Tools/FieldAudit does the same from the command line.
+    */
+    class BatchAudit  : private juce::Thread
+    {
+    public:
+        BatchAudit(const juce::File& folder, const Settings& settings, std::function<void(const juce::String&)> onFinished);
+        ~BatchAudit() override;
+
+        int getNumFilesDone() const { return filesDone.load(); }
+        int getNumFiles() const { return numFiles.load(); }
+        bool isFinished() const { return !isThreadRunning(); }
+
+    private:
+        void run() override;
+
+        juce::File folder;
+        Settings settings;
+        std::function<void(const juce::String&)> onFinished;
+        std::atomic<int> filesDone { 0 }, numFiles { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchAudit)
+    };
+}
@@ -0,0 +1,415 @@
+/*
+  ==============================================================================
+
+    StereoMatrix.h
+    Width/rotation matrix shared by every processing path of LPanner.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "cmath"
+#include "corecrt_math_defines.h"
+
+namespace StereoMatrix
+{
+    //==============================================================================
+    /** Width, rotation and post gain folded into one mid/side matrix.
+
+        midRotation  = midToMid  * mid + sideToMid  * side
+        sideRotation = midToSide * mid + sideToSide * side
+    */
+    struct Coefficients
+    {
+        double midToMid = 1.0;
+        double sideToMid = 0.0;
+        double midToSide = 0.0;
+        double sideToSide = 1.0;
+    };
+
+    /** Mid and side gains of the width stage, post gain included. */
+    struct WidthGains
+    {
+        double mid = 1.0;
+        double side = 1.0;
+    };
+
+    inline WidthGains makeWidthGains(double Theta_w, double outputGain)
+    {
+        WidthGains g;
+        g.mid = sin(M_PI / 4 - Theta_w) * sqrt(2) * outputGain;
+        g.side = cos(M_PI / 4 - Theta_w) * sqrt(2) * outputGain;
+        return g;
+    }
+
+    /** Builds the matrix from width gains and the sin/cos of the rotation angle. */
+    inline Coefficients make(const WidthGains& g, double cosRotation, double sinRotation)
+    {
+        Coefficients c;
+        c.midToMid = g.mid * cosRotation;
+        c.sideToMid = -g.side * sinRotation;
+        c.midToSide = g.mid * sinRotation;
+        c.sideToSide = g.side * cosRotation;
+        return c;
+    }
+
+    /** Theta_w / Theta_r are the angles derived from the width and rotation parameters. */
+    inline Coefficients make(double Theta_w, double Theta_r, double outputGain)
+    {
+        return make(makeWidthGains(Theta_w, outputGain), cos(Theta_r), sin(Theta_r));
+    }
+
+    /** Linear blend from a (t = 0) to b (t = 1). */
+    inline WidthGains mix(const WidthGains& a, const WidthGains& b, double t)
+    {
+        WidthGains g;
+        g.mid = a.mid + t * (b.mid - a.mid);
+        g.side = a.side + t * (b.side - a.side);
+        return g;
+    }
+
+    inline Coefficients mix(const Coefficients& a, const Coefficients& b, double t)
+    {
+        Coefficients c;
+        c.midToMid = a.midToMid + t * (b.midToMid - a.midToMid);
+        c.sideToMid = a.sideToMid + t * (b.sideToMid - a.sideToMid);
+        c.midToSide = a.midToSide + t * (b.midToSide - a.midToSide);
+        c.sideToSide = a.sideToSide + t * (b.sideToSide - a.sideToSide);
+        return c;
+    }
+
+    //==============================================================================
+    /** Channel layout on either side of the matrix.
+        MS carries M = (L + R) / 2 on channel 0 and S = (L - R) / 2 on channel 1,
+        so chained instances can stay in mid/side without re-encoding.
+    */
+    enum class Format { lr = 0, ms };
+
+    /** Running sums of the matrix output, accumulated inside the matrix pass.
+        mid/side here are the internal halves of the output: L = mid + side, R = mid - side.
+    */
+    struct Statistics
+    {
+        double midEnergy = 0.0;
+        double sideEnergy = 0.0;
+        double midSide = 0.0;
+        double peak = 0.0;          //max(|L|, |R|)
+        double numSamples = 0.0;
+
+        /** Merges another set of sums taken over following samples. */
+        void add(const Statistics& other)
+        {
+            midEnergy += other.midEnergy;
+            sideEnergy += other.sideEnergy;
+            midSide += other.midSide;
+            peak = juce::jmax(peak, other.peak);
+            numSamples += other.numSamples;
+        }
+
+        /** RMS of L and R together, 0 when nothing was measured. */
+        double getRMS() const
+        {
+            //(L^2 + R^2) / 2 = mid^2 + side^2
+            return numSamples > 0.0 ? std::sqrt((midEnergy + sideEnergy) / numSamples) : 0.0;
+        }
+
+        /** L/R correlation of the output, 0 when silent. */
+        double getCorrelation() const
+        {
+            //L = mid + side, R = mid - side
+            const double leftEnergy = midEnergy + 2.0 * midSide + sideEnergy;
+            const double rightEnergy = midEnergy - 2.0 * midSide + sideEnergy;
+            const double denominator = std::sqrt(leftEnergy * rightEnergy);
+            return denominator > 1.0e-12 ? (midEnergy - sideEnergy) / denominator : 0.0;
+        }
+
+        /** Side to mid energy ratio of the output, 0 when silent. */
+        double getSideToMidRatio() const
+        {
+            return midEnergy > 1.0e-12 ? sideEnergy / midEnergy : 0.0;
+        }
+
+        /** Leaky integration of one block's energy sums. */
+        void accumulate(const Statistics& block, double decay)
+        {
+            midEnergy = midEnergy * decay + block.midEnergy;
+            sideEnergy = sideEnergy * decay + block.sideEnergy;
+            midSide = midSide * decay + block.midSide;
+        }
+    };
+
+    //==============================================================================
+    /** Parts of the matrix a block actually needs. A kernel compiled without one
+        skips its arithmetic, so bypassed stages cost nothing in the sample loop.
+    */
+    namespace Feature
+    {
+        enum
+        {
+            width = 1,      //Mid and side gains differ
+            rotation = 2,   //Mid and side feed into each other
+            gain = 4,       //Common gain away from unity
+            all = width | rotation | gain
+        };
+    }
+
+    /** Features needed anywhere on a linear ramp from start to end. */
+    inline int getFeatures(const Coefficients& start, const Coefficients& end)
+    {
+        const double tolerance = 1.0e-9;
+        int features = 0;
+
+        for (const auto* c : { &start, &end }){
+            if (std::abs(c->sideToMid) > tolerance || std::abs(c->midToSide) > tolerance)
+                features |= Feature::rotation;
+            if (std::abs(c->midToMid - c->sideToSide) > tolerance)
+                features |= Feature::width;
+            if (std::abs(c->midToMid - 1.0) > tolerance)
+                features |= Feature::gain;
+        }
+
+        return features;
+    }
+
+    /** Applies the matrix to one sample pair.
+        The internal mid/side is L + R / L - R, so MS input enters at twice its level;
+        callers fold that into the output gain (see inputGain()).
+        Only the arithmetic for the given features is compiled in. The output is always
+        added to stats; every processing path meters it.
+    */
+    template <Format inputFormat, Format outputFormat, int features = Feature::all, class sampleType>
+    inline void processSample(sampleType& first, sampleType& second, const Coefficients& c, Statistics& stats)
+    {
+        //Generate MS signals
+        const double midInput = inputFormat == Format::ms ? (double)first : (double)first + second;
+        const double sideInput = inputFormat == Format::ms ? (double)second : (double)first - second;
+
+        double midRotation, sideRotation;
+        if ((features & Feature::rotation) != 0){
+            midRotation = c.midToMid * midInput + c.sideToMid * sideInput;
+            sideRotation = c.midToSide * midInput + c.sideToSide * sideInput;
+        }
+        else if ((features & Feature::width) != 0){
+            midRotation = c.midToMid * midInput;
+            sideRotation = c.sideToSide * sideInput;
+        }
+        else if ((features & Feature::gain) != 0){
+            midRotation = c.midToMid * midInput;
+            sideRotation = c.midToMid * sideInput;
+        }
+        else{
+            midRotation = midInput;
+            sideRotation = sideInput;
+        }
+
+        stats.midEnergy += midRotation * midRotation;
+        stats.sideEnergy += sideRotation * sideRotation;
+        stats.midSide += midRotation * sideRotation;
+        stats.peak = juce::jmax(stats.peak, std::abs(midRotation) + std::abs(sideRotation));
+
+        if (outputFormat == Format::ms){
+            first = (sampleType)midRotation;
+            second = (sampleType)sideRotation;
+        }
+        else{
+            //Revert to LR signals
+            first = (sampleType)(midRotation + sideRotation);
+            second = (sampleType)(midRotation - sideRotation);
+        }
+    }
+
+    /** Gain that brings an input format to the internal L + R / L - R level. */
+    inline double inputGain(Format inputFormat)
+    {
+        return inputFormat == Format::ms ? 2.0 : 1.0;
+    }
+
+    //==============================================================================
+    /** Applies the matrix to a block, ramping linearly from start to end. */
+    template <Format inputFormat, Format outputFormat, int features>
+    struct RampKernel
+    {
+        template <class sampleType>
+        static void run(sampleType* first, sampleType* second, int numSamples,
+                        const Coefficients& start, const Coefficients& end, Statistics& stats)
+        {
+            if (numSamples <= 0) return;
+
+            const double step = 1.0 / numSamples;
+            const double dMidToMid = (end.midToMid - start.midToMid) * step;
+            const double dSideToMid = (end.sideToMid - start.sideToMid) * step;
+            const double dMidToSide = (end.midToSide - start.midToSide) * step;
+            const double dSideToSide = (end.sideToSide - start.sideToSide) * step;
+
+            //Block-local sums keep the accumulators in registers
+            Statistics blockStats;
+
+            for (int i = 0; i < numSamples; ++i){
+                Coefficients c;
+                c.midToMid = start.midToMid + dMidToMid * (i + 1);
+                c.sideToMid = start.sideToMid + dSideToMid * (i + 1);
+                c.midToSide = start.midToSide + dMidToSide * (i + 1);
+                c.sideToSide = start.sideToSide + dSideToSide * (i + 1);
+
+                processSample<inputFormat, outputFormat, features>(first[i], second[i], c, blockStats);
+            }
+
+            blockStats.numSamples = numSamples;
+            stats.add(blockStats);
+        }
+    };
+
+    /** Applies a matrix that changes every sample; nextCoefficients() is called once per sample. */
+    template <Format inputFormat, Format outputFormat, int features>
+    struct EachSampleKernel
+    {
+        template <class sampleType, class CoefficientFunction>
+        static void run(sampleType* first, sampleType* second, int numSamples,
+                        CoefficientFunction& nextCoefficients, Statistics& stats)
+        {
+            Statistics blockStats;
+
+            for (int i = 0; i < numSamples; ++i)
+                processSample<inputFormat, outputFormat, features>(first[i], second[i], nextCoefficients(), blockStats);
+
+            blockStats.numSamples = numSamples;
+            stats.add(blockStats);
+        }
+    };
+
+    //==============================================================================
+    /** Index into the kernel tables: features in the low bits, then the formats. */
+    inline int makeKernelKey(Format inputFormat, Format outputFormat, int features)
+    {
+        return (features & Feature::all)
+             | (outputFormat == Format::ms ? 8 : 0)
+             | (inputFormat == Format::ms ? 16 : 0);
+    }
+
+    static constexpr int numKernels = 32;
+
+    template <template <Format, Format, int> class Kernel, int key>
+    using KernelFor = Kernel<(key & 16) != 0 ? Format::ms : Format::lr,
+                             (key & 8) != 0 ? Format::ms : Format::lr,
+                             key & Feature::all>;
+
+    /** Every instantiation of Kernel for one Function signature, in key order.
+        Dispatch is a single indexed call per block; the sample loops never branch on the flags.
+    */
+    template <class Function, template <Format, Format, int> class Kernel, int... keys>
+    inline Function lookupKernel(int key, std::integer_sequence<int, keys...>)
+    {
+        static constexpr Function table[] = { &KernelFor<Kernel, keys>::run... };
+        return table[key];
+    }
+
+    /** Ramps the matrix from start to end over the block.
+        Output statistics are added to stats when it is not nullptr; the kernels
+        measure either way, the sums are just dropped.
+    */
+    template <class sampleType>
+    inline void process(sampleType* first, sampleType* second, int numSamples,
+                        const Coefficients& start, const Coefficients& end,
+                        Format inputFormat, Format outputFormat, Statistics* stats = nullptr)
+    {
+        using Function = void (*)(sampleType*, sampleType*, int, const Coefficients&, const Coefficients&, Statistics&);
+
+        Statistics unused;
+        const int key = makeKernelKey(inputFormat, outputFormat, getFeatures(start, end));
+        lookupKernel<Function, RampKernel>(key, std::make_integer_sequence<int, numKernels>())
+            (first, second, numSamples, start, end, stats != nullptr ? *stats : unused);
+    }
+
+    /** Same as process(), with the coefficients held constant. */
+    template <class sampleType>
+    inline void process(sampleType* first, sampleType* second, int numSamples,
+                        const Coefficients& c, Format inputFormat, Format outputFormat, Statistics* stats = nullptr)
+    {
+        process(first, second, numSamples, c, c, inputFormat, outputFormat, stats);
+    }
+
+    /** Applies a matrix that changes every sample, see EachSampleKernel.
+        features must cover every matrix nextCoefficients() can return.
+    */
+    template <class sampleType, class CoefficientFunction>
+    inline void processEachSample(sampleType* first, sampleType* second, int numSamples, CoefficientFunction&& nextCoefficients,
+                                  Format inputFormat, Format outputFormat, Statistics* stats = nullptr, int features = Feature::all)
+    {
+        using Function = void (*)(sampleType*, sampleType*, int, typename std::remove_reference<CoefficientFunction>::type&, Statistics&);
+
+        Statistics unused;
+        const int key = makeKernelKey(inputFormat, outputFormat, features);
+        lookupKernel<Function, EachSampleKernel>(key, std::make_integer_sequence<int, numKernels>())
+            (first, second, numSamples, nextCoefficients, stats != nullptr ? *stats : unused);
+    }
+
+    //==============================================================================
+    /** LPFLink filters the channel the image is rotated away from: 1 for R, -1 for L, 0 for none. */
+    inline int getLowPassLinkSide(double Theta_r)
+    {
+        if (Theta_r > 0.0) return 1;
+        if (Theta_r < 0.0) return -1;
+        return 0;
+    }
+
+    /** LPFLink cutoff, sliding from 20 kHz to lpfFrequency with |rotation| / 100.
+        Limited since auto rotation can go past full scale. */
+    inline double getLowPassLinkFrequency(double Theta_r, double lpfFrequency)
+    {
+        double LPFBias = juce::jmin(1.0, std::abs(Theta_r) * 4 / M_PI);
+        return LPFBias * lpfFrequency + (1 - LPFBias) * 20000.0;
+    }
+
+    /** Biquad low pass as IIR::Coefficients::makeLowPass, written as b0, b1, b2, a1, a2 (a0 = 1). */
+    inline void makeLowPass(double sampleRate, double frequency, double Q, double* c)
+    {
+        auto n = 1.0 / std::tan(M_PI * juce::jlimit(1.0, sampleRate * 0.499, frequency) / sampleRate);
+        auto nSquared = n * n;
+        auto invQ = 1.0 / Q;
+        auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        c[0] = c1;
+        c[1] = c1 * 2.0;
+        c[2] = c1;
+        c[3] = c1 * 2.0 * (1.0 - nSquared);
+        c[4] = c1 * (1.0 - invQ * n + nSquared);
+    }
+
+    /** Decodes MS to LR, filters one side and encodes back; the side is fixed at compile time. */
+    template <bool filterRight, class sampleType, class FilterFunction>
+    inline void processLowPassLinkMS(sampleType* first, sampleType* second, int numSamples, FilterFunction& filter)
+    {
+        for (int i = 0; i < numSamples; ++i){
+            double left = (double)first[i] + second[i];
+            double right = (double)first[i] - second[i];
+
+            if (filterRight) right = filter(right);
+            else             left = filter(left);
+
+            first[i] = (sampleType)((left + right) * 0.5);
+            second[i] = (sampleType)((left - right) * 0.5);
+        }
+    }
+
+    /** Runs filter over the L (lpfSide < 0) or R (lpfSide > 0) channel of the
+        matrix output, decoding to LR and back when the output is MS.
+    */
+    template <class sampleType, class FilterFunction>
+    inline void processLowPassLink(sampleType* first, sampleType* second, int numSamples,
+                                   int lpfSide, Format outputFormat, FilterFunction&& filter)
+    {
+        if (lpfSide == 0) return;
+
+        if (outputFormat == Format::lr){
+            auto* channel = lpfSide > 0 ? second : first;
+            for (int i = 0; i < numSamples; ++i)
+                channel[i] = (sampleType)filter((double)channel[i]);
+            return;
+        }
+
+        if (lpfSide > 0) processLowPassLinkMS<true>(first, second, numSamples, filter);
+        else             processLowPassLinkMS<false>(first, second, numSamples, filter);
+    }
+}
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    TransientDetector.h
+    Transient amount from dual envelope followers on mid and side.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "cmath"
+
+//==============================================================================
+/** Fast and slow envelope followers on mid and side energy. Both settle on the
+    mean energy of a steady signal; where the fast one runs ahead of the slow one
+    the signal is a transient. The amount (0..1) is smoothed into a gain curve
+    with a quick attack and a slower release.
+
+    The four followers are the lanes of one array with their own coefficients, so
+    each sample is one branch-free update the compiler can do as a vector operation.
+*/
+class TransientDetector
+{
+public:
+    void prepare(double sampleRate)
+    {
+        setSampleRate(sampleRate);
+        reset();
+    }
+
+    /** Re-tunes the time constants but keeps the envelopes, for rate changes mid-stream. */
+    void setSampleRate(double sampleRate)
+    {
+        //Lanes: mid fast, mid slow, side fast, side slow
+        static const double seconds[numLanes] = { 0.005, 0.06, 0.005, 0.06 };
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            coefficient[lane] = getCoefficient(seconds[lane], sampleRate);
+
+        curveAttack = getCoefficient(0.001, sampleRate);
+        curveRelease = getCoefficient(0.05, sampleRate);
+    }
+
+    void reset()
+    {
+        for (auto& value : envelope)
+            value = 0.0;
+        curveState = 0.0;
+    }
+
+    /** Writes the transient amount for every sample of an LR (or MS) pair into curve. */
+    template <class sampleType>
+    void process(const sampleType* first, const sampleType* second, int numSamples, bool inputIsMS, float* curve)
+    {
+        //Mid/side scale does not matter, only the ratio of the followers
+        const double secondToMid = inputIsMS ? 0.0 : 1.0;
+        const double firstToSide = inputIsMS ? 0.0 : 1.0;
+        const double secondToSide = inputIsMS ? 1.0 : -1.0;
+
+        for (int i = 0; i < numSamples; ++i){
+            const double mid = (double)first[i] + secondToMid * second[i];
+            const double side = firstToSide * first[i] + secondToSide * second[i];
+            const double input[numLanes] = { mid * mid, mid * mid, side * side, side * side };
+
+            for (int lane = 0; lane < numLanes; ++lane)
+                envelope[lane] += coefficient[lane] * (input[lane] - envelope[lane]);
+
+            //Fast over slow energy: 0 up to +1.8 dB (ripple of steady bass), 1 from +4.8 dB
+            const double midRatio = envelope[0] / (envelope[1] + silenceFloor);
+            const double sideRatio = envelope[2] / (envelope[3] + silenceFloor);
+            const double amount = juce::jlimit(0.0, 1.0, (juce::jmax(midRatio, sideRatio) - 1.5) / 1.5);
+
+            curveState += (amount > curveState ? curveAttack : curveRelease) * (amount - curveState);
+            curve[i] = (float)curveState;
+        }
+    }
+
+private:
+    static constexpr int numLanes = 4;
+    static constexpr double silenceFloor = 1.0e-10;   //Energy; keeps noise and silence from reading as transients
+
+    static double getCoefficient(double seconds, double sampleRate)
+    {
+        return 1.0 - std::exp(-1.0 / (seconds * sampleRate));
+    }
+
+    double envelope[numLanes] = {};
+    double coefficient[numLanes] = {};
+    double curveState = 0.0, curveAttack = 1.0, curveRelease = 1.0;
+};
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    TestSignals.h
+    Deterministic stereo test signals shared by the LPanner test targets.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "cmath"
+#include "corecrt_math_defines.h"
+
+namespace TestSignals
+{
+    enum class Kind { noise = 0, sweep, impulses };
+    static constexpr int numKinds = 3;
+
+    inline const char* getName(Kind kind)
+    {
+        switch (kind){
+        case Kind::noise: return "noise";
+        case Kind::sweep: return "sweep";
+        default:          return "impulses";
+        }
+    }
+
+    /** Fills both channels of buffer. The same arguments always give the same samples,
+        so golden files stay comparable between builds.
+
+        noise       partly correlated white noise, so there is mid and side content
+        sweep       logarithmic 20 Hz to 0.45 x sampleRate, R a quarter turn behind L
+        impulses    every impulseSpacing samples, on L, on R, then on both with R inverted
+    */
+    inline void generate(Kind kind, juce::AudioBuffer<double>& buffer, double sampleRate)
+    {
+        const int numSamples = buffer.getNumSamples();
+        auto* left = buffer.getWritePointer(0);
+        auto* right = buffer.getWritePointer(1);
+        buffer.clear();
+
+        if (kind == Kind::noise){
+            juce::Random random(0x4c50616e);
+            for (int i = 0; i < numSamples; ++i){
+                const double common = random.nextDouble() * 2.0 - 1.0;
+                left[i] = 0.4 * (random.nextDouble() * 2.0 - 1.0) + 0.2 * common;
+                right[i] = 0.4 * (random.nextDouble() * 2.0 - 1.0) + 0.2 * common;
+            }
+        }
+        else if (kind == Kind::sweep){
+            const double startFrequency = 20.0;
+            const double endFrequency = 0.45 * sampleRate;
+            const double growth = std::log(endFrequency / startFrequency) / juce::jmax(1, numSamples - 1);
+            double phase = 0.0;
+            for (int i = 0; i < numSamples; ++i){
+                left[i] = 0.5 * std::sin(phase);
+                right[i] = 0.5 * std::sin(phase - M_PI / 2);
+                phase += 2.0 * M_PI * startFrequency * std::exp(growth * i) / sampleRate;
+            }
+        }
+        else{
+            const int impulseSpacing = 997;
+            for (int i = 0, n = 0; i < numSamples; i += impulseSpacing, ++n){
+                if (n % 3 != 1) left[i] = 0.9;
+                if (n % 3 != 0) right[i] = n % 3 == 2 ? -0.9 : 0.9;
+            }
+        }
+    }
+}
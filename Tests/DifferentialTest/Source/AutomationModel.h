@@ -0,0 +1,355 @@
+/*
+  ==============================================================================
+
+    AutomationModel.h
+    Scalar model of how LPanner moves its matrix under automation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "cmath"
+#include "corecrt_math_defines.h"
+#include "../../../Source/TransientDetector.h"
+#include "../../../Source/SidechainEnvelope.h"
+
+//==============================================================================
+/** The Standard and Eco paths with parameters that change between host blocks,
+    one sample at a time in double precision: linear ramps of smoothingSeconds
+    that restart whenever a target moves, the matrix each path builds from them,
+    and the transient, sidechain, auto-rotate and auto-width blends on top.
+
+    As in ReferenceModel the matrix is restated from the angles (cos - sin, no
+    StereoMatrix helpers, std::cos instead of the SineTable), so a slip in a
+    kernel, its dispatch or the ramp bookkeeping shows up as a difference. The
+    transient and sidechain curves come from the plugin's own detectors; they are
+    inputs to the blends checked here, not part of them.
+
+    LPF-Link is left out: its coefficients move with the rotation, and how a filter
+    carries its state across that depends on its structure, which ReferenceModel
+    deliberately does not copy.
+*/
+class AutomationModel
+{
+public:
+    enum class Path { standard, eco };
+
+    struct Settings
+    {
+        Path path = Path::standard;
+        bool transientWidth = false, autoRotate = false, autoWidth = false;
+
+        //Plain parameter values; the sidechain runs when it is given and a depth is not 0
+        double sidechainWidth = 0.0, sidechainRotation = 0.0;
+        float sidechainThreshold = -30.0f;
+        double sidechainAttack = 5.0, sidechainRelease = 200.0;
+
+        double autoRotateDepth = 50.0;
+        double autoRotateFrequency = 0.5;   //Hz; 1 Bar at the 120 bpm a host without a play head gets
+        double autoWidthCorrelation = 0.5;
+    };
+
+    AutomationModel(const Settings& s, double rate)
+        : settings(s), sampleRate(rate), rampSteps((int)std::floor(smoothingSeconds * rate))
+    {
+        sidechainWidthOffset = M_PI / 200.0 * s.sidechainWidth;
+        sidechainRotationOffset = -M_PI / 400.0 * s.sidechainRotation;
+        transientDetector.prepare(rate);
+    }
+
+    /** Processes one host block of LR samples in place, with the plain parameter
+        values the host set before it. sidechain holds two channels or is nullptr. */
+    void processBlock(double* left, double* right, const double* const* sidechain, int numSamples,
+                      double width, double rotation, double gain)
+    {
+        double Theta_w = M_PI / 200.0 * (width - 50.0);
+        const double Theta_r = -M_PI / 400.0 * rotation;
+
+        //Auto width starts from the Width parameter, then only the controller moves it
+        if (settings.autoWidth){
+            if (!autoWidthActive){
+                autoWidthTheta = Theta_w;
+                midEnergy = sideEnergy = midSide = 0.0;
+                autoWidthActive = true;
+            }
+            Theta_w = autoWidthTheta;
+        }
+
+        //The detector only runs while the width stage widens, and starts clean each time
+        const bool isTransient = settings.transientWidth && (Theta_w > 0.0 || widthRamp.current > 0.0);
+        if (isTransient && !transientActive)
+            transientDetector.reset();
+        transientActive = isTransient;
+
+        widthRamp.setTarget(Theta_w, rampSteps);
+        rotationRamp.setTarget(Theta_r, rampSteps);
+        gainRamp.setTarget(gain * gain, rampSteps);
+
+        transientCurve.resize((size_t)numSamples);
+        if (isTransient)
+            transientDetector.process(left, right, numSamples, false, transientCurve.data());
+
+        sidechainCurve.resize((size_t)numSamples);
+        isSidechain = sidechain != nullptr && (sidechainWidthOffset != 0.0 || sidechainRotationOffset != 0.0);
+        if (isSidechain){
+            sidechainEnvelope.setTimes(settings.sidechainAttack / 1000.0, settings.sidechainRelease / 1000.0, sampleRate);
+            sidechainEnvelope.process(sidechain, 2, numSamples, juce::Decibels::decibelsToGain(settings.sidechainThreshold),
+                                      sidechainCurve.data());
+        }
+
+        blockMidEnergy = blockSideEnergy = blockMidSide = 0.0;
+
+        if (settings.autoRotate)
+            processModulated(left, right, numSamples, isTransient, settings.path == Path::eco ? ecoInterval : modulationInterval);
+        else if (settings.path == Path::eco)
+            processEco(left, right, numSamples, isTransient);
+        else
+            processStandard(left, right, numSamples, isTransient);
+
+        if (settings.autoWidth)
+            updateAutoWidth(numSamples);
+    }
+
+private:
+    //The processor's constants, restated
+    static constexpr double smoothingSeconds = 0.05;
+    static constexpr int modulationInterval = 32;
+    static constexpr int ecoInterval = 64;
+    static constexpr double autoWidthTimeConstant = 0.3;
+    static constexpr double autoWidthRate = 0.5;
+
+    /** Linear ramp with the bookkeeping of juce::SmoothedValue: a new target restarts
+        the full ramp from wherever the value is, skipping past the end lands on it. */
+    struct Ramp
+    {
+        double current = 0.0, target = 0.0, step = 0.0;
+        int countdown = 0;
+
+        void setTarget(double newTarget, int numSteps)
+        {
+            if (newTarget == target) return;
+            target = newTarget;
+            countdown = numSteps;
+            step = (target - current) / numSteps;
+        }
+
+        double skip(int numSamples)
+        {
+            if (numSamples >= countdown){
+                current = target;
+                countdown = 0;
+            }
+            else{
+                current += step * numSamples;
+                countdown -= numSamples;
+            }
+            return current;
+        }
+    };
+
+    struct Gains
+    {
+        double mid, side;
+    };
+
+    struct Matrix
+    {
+        double midToMid, sideToMid, midToSide, sideToSide;
+    };
+
+    static Gains makeGains(double Theta_w, double outputGain)
+    {
+        return { (std::cos(Theta_w) - std::sin(Theta_w)) * outputGain, (std::cos(Theta_w) + std::sin(Theta_w)) * outputGain };
+    }
+
+    /** Transient width holds a widening setting back to equal mid and side gain. */
+    static Gains makeNeutralGains(const Gains& g, double Theta_w, double outputGain)
+    {
+        return Theta_w > 0.0 ? Gains { outputGain, outputGain } : g;
+    }
+
+    static Gains mix(const Gains& a, const Gains& b, double t)
+    {
+        return { a.mid + t * (b.mid - a.mid), a.side + t * (b.side - a.side) };
+    }
+
+    static Matrix makeMatrix(const Gains& g, double Theta_r)
+    {
+        const double c = std::cos(Theta_r), s = std::sin(Theta_r);
+        return { g.mid * c, -g.side * s, g.mid * s, g.side * c };
+    }
+
+    static Matrix mix(const Matrix& a, const Matrix& b, double t)
+    {
+        return { a.midToMid + t * (b.midToMid - a.midToMid), a.sideToMid + t * (b.sideToMid - a.sideToMid),
+                 a.midToSide + t * (b.midToSide - a.midToSide), a.sideToSide + t * (b.sideToSide - a.sideToSide) };
+    }
+
+    /** The sidechain offsets both angles before the matrix is built, then the transient blend applies. */
+    Matrix makePushed(double Theta_w, double Theta_r, double outputGain, double sidechainAmount, double transientAmount) const
+    {
+        Theta_w = juce::jlimit(-M_PI / 4, M_PI / 4, Theta_w + sidechainAmount * sidechainWidthOffset);
+        Theta_r += sidechainAmount * sidechainRotationOffset;
+
+        auto g = makeGains(Theta_w, outputGain);
+        if (transientAmount > 0.0)
+            g = mix(g, makeNeutralGains(g, Theta_w, outputGain), transientAmount);
+
+        return makeMatrix(g, Theta_r);
+    }
+
+    void apply(const Matrix& m, double& left, double& right)
+    {
+        const double mid = left + right;
+        const double side = left - right;
+        const double rotatedMid = m.midToMid * mid + m.sideToMid * side;
+        const double rotatedSide = m.midToSide * mid + m.sideToSide * side;
+
+        blockMidEnergy += rotatedMid * rotatedMid;
+        blockSideEnergy += rotatedSide * rotatedSide;
+        blockMidSide += rotatedMid * rotatedSide;
+
+        left = rotatedMid + rotatedSide;
+        right = rotatedMid - rotatedSide;
+    }
+
+    /** Matrix ramped linearly across the block; the sidechain ramps the angles instead. */
+    void processStandard(double* left, double* right, int numSamples, bool isTransient)
+    {
+        const double startWidth = widthRamp.current, startRotation = rotationRamp.current, startGain = gainRamp.current;
+        const double endWidth = widthRamp.skip(numSamples);
+        const double endRotation = rotationRamp.skip(numSamples);
+        const double endGain = gainRamp.skip(numSamples);
+
+        const auto startGains = makeGains(startWidth, startGain), endGains = makeGains(endWidth, endGain);
+        const auto start = makeMatrix(startGains, startRotation), end = makeMatrix(endGains, endRotation);
+        const auto startNeutral = makeMatrix(makeNeutralGains(startGains, startWidth, startGain), startRotation);
+        const auto endNeutral = makeMatrix(makeNeutralGains(endGains, endWidth, endGain), endRotation);
+
+        for (int i = 0; i < numSamples; ++i){
+            const double t = (i + 1) / (double)numSamples;
+            const double transientAmount = isTransient ? transientCurve[(size_t)i] : 0.0;
+
+            Matrix m;
+            if (isSidechain)
+                m = makePushed(startWidth + t * (endWidth - startWidth), startRotation + t * (endRotation - startRotation),
+                               startGain + t * (endGain - startGain), sidechainCurve[(size_t)i], transientAmount);
+            else if (isTransient)
+                m = mix(mix(start, end, t), mix(startNeutral, endNeutral, t), transientAmount);
+            else
+                m = mix(start, end, t);
+
+            apply(m, left[i], right[i]);
+        }
+    }
+
+    /** One matrix per interval, at the ramps' values at its end and the curves' interval means. */
+    void processEco(double* left, double* right, int numSamples, bool isTransient)
+    {
+        for (int start = 0; start < numSamples; start += ecoInterval){
+            const int num = juce::jmin(numSamples - start, ecoInterval);
+
+            widthRamp.skip(num);
+            rotationRamp.skip(num);
+            gainRamp.skip(num);
+
+            double transientAmount = 0.0, sidechainAmount = 0.0;
+            for (int i = start; i < start + num; ++i){
+                transientAmount += isTransient ? transientCurve[(size_t)i] : 0.0;
+                sidechainAmount += isSidechain ? sidechainCurve[(size_t)i] : 0.0;
+            }
+
+            const auto m = makePushed(widthRamp.current, rotationRamp.current, gainRamp.current,
+                                      sidechainAmount / num, transientAmount / num);
+            for (int i = start; i < start + num; ++i)
+                apply(m, left[i], right[i]);
+        }
+    }
+
+    /** Auto rotation: width gains ramp per interval, the rotation angle moves every sample. */
+    void processModulated(double* left, double* right, int numSamples, bool isTransient, int interval)
+    {
+        const double depth = M_PI / 400.0 * settings.autoRotateDepth;
+
+        for (int start = 0; start < numSamples; start += interval){
+            const int num = juce::jmin(numSamples - start, interval);
+
+            const double startWidth = widthRamp.current, startRotation = rotationRamp.current, startGain = gainRamp.current;
+            const double endWidth = widthRamp.skip(num);
+            const double endRotation = rotationRamp.skip(num);
+            const double endGain = gainRamp.skip(num);
+            const auto startGains = makeGains(startWidth, startGain), endGains = makeGains(endWidth, endGain);
+
+            for (int index = 1; index <= num; ++index){
+                const int i = start + index - 1;
+                const double t = index / (double)num;
+
+                double angle = startRotation + t * (endRotation - startRotation) + depth * std::sin(2.0 * M_PI * lfoPhase);
+                lfoPhase += settings.autoRotateFrequency / sampleRate;
+                if (lfoPhase >= 1.0) lfoPhase -= 1.0;
+
+                double Theta_w = startWidth + t * (endWidth - startWidth);
+                const double outputGain = startGain + t * (endGain - startGain);
+                auto g = mix(startGains, endGains, t);
+
+                if (isSidechain){
+                    const double amount = sidechainCurve[(size_t)i];
+                    angle += amount * sidechainRotationOffset;
+                    Theta_w = juce::jlimit(-M_PI / 4, M_PI / 4, Theta_w + amount * sidechainWidthOffset);
+                    g = makeGains(Theta_w, outputGain);
+                }
+
+                if (isTransient)
+                    g = mix(g, makeNeutralGains(g, Theta_w, outputGain), transientCurve[(size_t)i]);
+
+                apply(makeMatrix(g, angle), left[i], right[i]);
+            }
+        }
+    }
+
+    /** Integrating controller on the output's L/R correlation, held through silence. */
+    void updateAutoWidth(int numSamples)
+    {
+        const double blockSeconds = numSamples / sampleRate;
+        if (blockMidEnergy + blockSideEnergy < 1.0e-8 * numSamples)
+            return;
+
+        const double decay = std::exp(-blockSeconds / autoWidthTimeConstant);
+        midEnergy = midEnergy * decay + blockMidEnergy;
+        sideEnergy = sideEnergy * decay + blockSideEnergy;
+        midSide = midSide * decay + blockMidSide;
+
+        //L = mid + side, R = mid - side
+        const double leftEnergy = midEnergy + 2.0 * midSide + sideEnergy;
+        const double rightEnergy = midEnergy - 2.0 * midSide + sideEnergy;
+        const double denominator = std::sqrt(leftEnergy * rightEnergy);
+        const double correlation = denominator > 1.0e-12 ? (midEnergy - sideEnergy) / denominator : 0.0;
+
+        autoWidthTheta = juce::jlimit(-M_PI / 4, M_PI / 4,
+                                      autoWidthTheta + autoWidthRate * (correlation - settings.autoWidthCorrelation) * blockSeconds);
+    }
+
+    Settings settings;
+    double sampleRate;
+    int rampSteps;
+    Ramp widthRamp, rotationRamp, gainRamp;
+
+    TransientDetector transientDetector;
+    bool transientActive = false;
+    std::vector<float> transientCurve;
+
+    SidechainEnvelope sidechainEnvelope;
+    double sidechainWidthOffset = 0.0, sidechainRotationOffset = 0.0;
+    bool isSidechain = false;
+    std::vector<float> sidechainCurve;
+
+    double lfoPhase = 0.0;
+
+    bool autoWidthActive = false;
+    double autoWidthTheta = 0.0;
+    double midEnergy = 0.0, sideEnergy = 0.0, midSide = 0.0;
+    double blockMidEnergy = 0.0, blockSideEnergy = 0.0, blockMidSide = 0.0;
+};
@@ -0,0 +1,869 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Differential test: every LPanner processing variant against ReferenceModel.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/ParameterSweep.h"
+#include "../../Common/TestSignals.h"
+#include "ReferenceModel.h"
+#include "AutomationModel.h"
+
+//==============================================================================
+/*  Runs the processor as a host would for every precision, quality, LR/MS pair and
+    bypass combination, on noise, a sweep and impulses, in several block sizes, and
+    compares its output with ReferenceModel. Parameters are held steady and the ramps
+    settle on silence first, so every difference comes from the processing path and
+    not from its smoothing.
+
+    A second set of runs automates Width, Rotation and Gain every host block and
+    compares with AutomationModel, which follows the ramps sample by sample, so the
+    ramped kernels, the per-sample kernels and the transient, sidechain, auto-rotate
+    and auto-width blends are checked while they move.
+*/
+namespace
+{
+    const char* const usage =
+        "Usage: LPannerDifferentialTest [options]\n"
+        "  --sample-rate=<Hz>          default 48000\n"
+        "  --seconds=<s>               signal length per run, default 0.25\n"
+        "  --block-sizes=<list>        comma separated, 0 for varying sizes, default 1,7,64,333,512,0\n"
+        "  --float-tolerance=<dB>      largest error below the reference peak, default -120\n"
+        "  --double-tolerance=<dB>     default -200\n"
+        "  --table-tolerance=<dB>      auto-rotate runs, bounded by the SineTable, default -100\n"
+        "  --write-golden=<folder>     store every output there\n"
+        "  --compare-golden=<folder>   compare every output with the one stored there, same tolerances\n"
+        "  --verbose                   one line per run instead of per variant\n"
+        "Returns 0 when every variant, automation run and ParameterSweep setting is within tolerance.\n";
+
+    constexpr int maxBlockSize = 512;
+    constexpr double settleSeconds = 0.1;       //Twice the processor's smoothing time
+    constexpr double exactDecibels = -400.0;
+    constexpr int goldenMagic = 0x4c50474c;     //"LPGL"
+
+    struct Options
+    {
+        double sampleRate = 48000.0;
+        double seconds = 0.25;
+        juce::Array<int> blockSizes { 1, 7, 64, 333, maxBlockSize, 0 };
+        double floatTolerance = -120.0;
+        double doubleTolerance = -200.0;
+        double tableTolerance = -100.0;     //SineTable interpolates linearly between 1024 points
+        juce::File writeGolden, compareGolden;
+        bool verbose = false;
+    };
+
+    enum class Quality { eco = 0, standard, high };     //Choice order of the "quality" parameter
+
+    struct Variant
+    {
+        bool doublePrecision = false;
+        Quality quality = Quality::standard;
+        bool msInput = false, msOutput = false;
+        bool widthBypass = false, rotationBypass = false, lpfLink = false;
+        bool masterBypass = false;
+    };
+
+    struct ParameterSet
+    {
+        double width, rotation, gain, lpfFrequency;
+    };
+
+    //A widening setting turned one way and a narrowing one turned the other, so both LPF-Link sides run
+    const ParameterSet parameterSets[] = { { 80.0, 45.0, 0.8, 1500.0 }, { 25.0, -70.0, 0.6, 3000.0 } };
+
+    //==============================================================================
+    Options parseOptions(const juce::ArgumentList& args)
+    {
+        Options options;
+        auto value = [&args](const char* option){ return args.getValueForOption(option); };
+
+        if (value("--sample-rate").isNotEmpty())
+            options.sampleRate = juce::jmax(8000.0, value("--sample-rate").getDoubleValue());
+        if (value("--seconds").isNotEmpty())
+            options.seconds = juce::jmax(0.01, value("--seconds").getDoubleValue());
+        if (value("--float-tolerance").isNotEmpty())
+            options.floatTolerance = value("--float-tolerance").getDoubleValue();
+        if (value("--double-tolerance").isNotEmpty())
+            options.doubleTolerance = value("--double-tolerance").getDoubleValue();
+        if (value("--table-tolerance").isNotEmpty())
+            options.tableTolerance = value("--table-tolerance").getDoubleValue();
+
+        if (value("--block-sizes").isNotEmpty()){
+            options.blockSizes.clear();
+            for (auto& size : juce::StringArray::fromTokens(value("--block-sizes"), ",", ""))
+                options.blockSizes.addIfNotAlreadyThere(juce::jlimit(0, maxBlockSize, size.trim().getIntValue()));
+        }
+
+        auto cwd = juce::File::getCurrentWorkingDirectory();
+        if (value("--write-golden").isNotEmpty())
+            options.writeGolden = cwd.getChildFile(value("--write-golden"));
+        if (value("--compare-golden").isNotEmpty())
+            options.compareGolden = cwd.getChildFile(value("--compare-golden"));
+
+        options.verbose = args.containsOption("--verbose");
+        return options;
+    }
+
+    std::vector<Variant> makeVariants()
+    {
+        std::vector<Variant> variants;
+
+        for (int precision = 0; precision < 2; ++precision)
+            for (int quality = 0; quality < 3; ++quality)
+                for (int formats = 0; formats < 4; ++formats)
+                    for (int stages = 0; stages <= 8; ++stages){
+                        //Every combination of width, rotation and LPF-Link, then master bypass
+                        Variant variant;
+                        variant.doublePrecision = precision != 0;
+                        variant.quality = (Quality)quality;
+                        variant.msInput = (formats & 2) != 0;
+                        variant.msOutput = (formats & 1) != 0;
+                        variant.widthBypass = (stages & 1) != 0;
+                        variant.rotationBypass = (stages & 2) != 0;
+                        variant.lpfLink = (stages & 4) == 0;
+                        variant.masterBypass = stages == 8;
+                        variants.push_back(variant);
+                    }
+
+        return variants;
+    }
+
+    juce::String getQualityName(Quality quality)
+    {
+        return quality == Quality::eco ? "Eco" : quality == Quality::high ? "High" : "Standard";
+    }
+
+    /** W, R and L for the active width, rotation and LPF-Link stages. */
+    juce::String getStages(const Variant& variant)
+    {
+        if (variant.masterBypass) return "bypass";
+
+        return juce::String(variant.widthBypass ? "-" : "W")
+             + (variant.rotationBypass ? "-" : "R")
+             + (variant.lpfLink ? "L" : "-");
+    }
+
+    juce::String getVariantName(const Variant& variant)
+    {
+        return juce::String(variant.doublePrecision ? "double" : "float").paddedRight(' ', 8)
+             + getQualityName(variant.quality).paddedRight(' ', 10)
+             + juce::String(variant.msInput ? "MS>" : "LR>") + (variant.msOutput ? "MS  " : "LR  ")
+             + getStages(variant).paddedRight(' ', 8);
+    }
+
+    juce::String getBlockName(int blockSize)
+    {
+        return blockSize > 0 ? juce::String(blockSize) : juce::String("var");
+    }
+
+    /** Name of one run's golden file; only characters every file system accepts. */
+    juce::String getRunKey(const Variant& variant, int blockSize, TestSignals::Kind kind, int set)
+    {
+        return juce::String(variant.doublePrecision ? "double" : "float")
+             + "_" + getQualityName(variant.quality).toLowerCase()
+             + "_" + (variant.msInput ? "ms" : "lr") + "-" + (variant.msOutput ? "ms" : "lr")
+             + "_" + getStages(variant)
+             + "_b" + getBlockName(blockSize)
+             + "_" + TestSignals::getName(kind)
+             + "_p" + juce::String(set);
+    }
+
+    juce::String formatDecibels(double decibels)
+    {
+        return decibels <= exactDecibels ? juce::String("exact") : juce::String(decibels, 1) + " dB";
+    }
+
+    //==============================================================================
+    struct Error
+    {
+        double maxError = 0.0;
+        double peak = 0.0;
+
+        /** Largest error relative to the expected peak. */
+        double getDecibels() const
+        {
+            return juce::Decibels::gainToDecibels(maxError / juce::jmax(peak, 1.0e-12), exactDecibels);
+        }
+    };
+
+    Error measure(const juce::AudioBuffer<double>& output, const juce::AudioBuffer<double>& expected)
+    {
+        Error error;
+
+        for (int channel = 0; channel < 2; ++channel){
+            auto* result = output.getReadPointer(channel);
+            auto* reference = expected.getReadPointer(channel);
+            for (int i = 0; i < expected.getNumSamples(); ++i){
+                //A NaN compares false everywhere, so it has to be caught explicitly
+                const double difference = std::isfinite(result[i]) ? std::abs(result[i] - reference[i])
+                                                                   : std::numeric_limits<double>::infinity();
+                error.maxError = juce::jmax(error.maxError, difference);
+                error.peak = juce::jmax(error.peak, std::abs(reference[i]));
+            }
+        }
+
+        return error;
+    }
+
+    //==============================================================================
+    /** Sets a parameter as a host would; returns the value the processor reads back,
+        which for a float parameter is value rounded through its normalised range. */
+    double setParameter(juce::AudioProcessor& processor, const juce::String& parameterID, double value)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                if (ranged->paramID == parameterID){
+                    ranged->setValueNotifyingHost(ranged->convertTo0to1((float)value));
+                    if (auto* floatParameter = dynamic_cast<juce::AudioParameterFloat*>(ranged))
+                        return floatParameter->get();
+                    return value;
+                }
+
+        std::cerr << "Unknown parameter " << parameterID << std::endl;
+        jassertfalse;
+        return value;
+    }
+
+    void configure(juce::AudioProcessor& processor, const Variant& variant, const ParameterSet& set)
+    {
+        setParameter(processor, "masterbypass", variant.masterBypass ? 1.0 : 0.0);
+        setParameter(processor, "quality", (double)variant.quality);
+        setParameter(processor, "inputformat", variant.msInput ? 1.0 : 0.0);
+        setParameter(processor, "outputformat", variant.msOutput ? 1.0 : 0.0);
+        setParameter(processor, "widthbypass", variant.widthBypass ? 1.0 : 0.0);
+        setParameter(processor, "rotationbypass", variant.rotationBypass ? 1.0 : 0.0);
+        setParameter(processor, "lpflink", variant.lpfLink ? 1.0 : 0.0);
+
+        setParameter(processor, "width", set.width);
+        setParameter(processor, "rotation", set.rotation);
+        setParameter(processor, "gain", set.gain);
+        setParameter(processor, "lpffreq", set.lpfFrequency);
+    }
+
+    /** Runs a fresh processor over input in blocks of blockSize (0: varying sizes). */
+    template <class sampleType>
+    juce::AudioBuffer<double> renderProcessor(const Variant& variant, const ParameterSet& set,
+                                              const juce::AudioBuffer<double>& input, int blockSize, double sampleRate)
+    {
+        StereoPanAudioProcessor processor;
+        configure(processor, variant, set);
+        processor.setProcessingPrecision(variant.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                 : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+        processor.prepareToPlay(sampleRate, maxBlockSize);
+
+        juce::MidiBuffer midi;
+        juce::Random random(0x426c6b73);    //The same varying sizes every run
+        auto nextBlockSize = [&](){ return blockSize > 0 ? blockSize : 1 + random.nextInt(maxBlockSize); };
+
+        //Ramps settle on silence; the matrix output and every filter stay at zero meanwhile
+        juce::AudioBuffer<sampleType> silence(2, maxBlockSize);
+        for (int done = 0; done < juce::roundToInt(settleSeconds * sampleRate); ){
+            const int numSamples = nextBlockSize();
+            silence.clear();
+            juce::AudioBuffer<sampleType> block(silence.getArrayOfWritePointers(), 2, numSamples);
+            processor.processBlock(block, midi);
+            done += numSamples;
+        }
+
+        const int totalSamples = input.getNumSamples();
+        juce::AudioBuffer<sampleType> io(2, totalSamples);
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < totalSamples; ++i)
+                io.setSample(channel, i, (sampleType)input.getSample(channel, i));
+
+        for (int start = 0; start < totalSamples; ){
+            const int numSamples = juce::jmin(nextBlockSize(), totalSamples - start);
+            juce::AudioBuffer<sampleType> block(io.getArrayOfWritePointers(), 2, start, numSamples);
+            processor.processBlock(block, midi);
+            start += numSamples;
+        }
+
+        processor.releaseResources();
+
+        juce::AudioBuffer<double> output(2, totalSamples);
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < totalSamples; ++i)
+                output.setSample(channel, i, (double)io.getSample(channel, i));
+
+        return output;
+    }
+
+    juce::AudioBuffer<double> renderReference(const Variant& variant, const ParameterSet& set,
+                                              const juce::AudioBuffer<double>& input, double sampleRate)
+    {
+        juce::AudioBuffer<double> output(input);
+        if (variant.masterBypass) return output;
+
+        ReferenceModel::Settings settings;
+        settings.width = set.width;
+        settings.rotation = set.rotation;
+        settings.gain = set.gain;
+        settings.lpfFrequency = set.lpfFrequency;
+        settings.widthBypass = variant.widthBypass;
+        settings.rotationBypass = variant.rotationBypass;
+        settings.lpfLink = variant.lpfLink;
+        settings.msInput = variant.msInput;
+        settings.msOutput = variant.msOutput;
+        settings.onePoleLowPass = variant.quality == Quality::eco;
+
+        auto run = [](ReferenceModel& model, double* first, double* second, int numSamples){
+            for (int i = 0; i < numSamples; ++i)
+                model.processSample(first[i], second[i]);
+        };
+
+        if (variant.quality != Quality::high){
+            ReferenceModel model(settings, sampleRate);
+            run(model, output.getWritePointer(0), output.getWritePointer(1), output.getNumSamples());
+            return output;
+        }
+
+        //High is the same model at twice the rate inside the processor's 2x half-band
+        //oversampler; the resampler's own response is part of that design, not an error
+        ReferenceModel model(settings, sampleRate * 2.0);
+        juce::dsp::Oversampling<double> oversampler(2, 1, juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR, true);
+        oversampler.initProcessing((size_t)maxBlockSize);
+
+        juce::dsp::AudioBlock<double> block(output);
+        for (size_t start = 0; start < block.getNumSamples(); start += maxBlockSize){
+            auto subBlock = block.getSubBlock(start, juce::jmin((size_t)maxBlockSize, block.getNumSamples() - start));
+            auto upBlock = oversampler.processSamplesUp(subBlock);
+            run(model, upBlock.getChannelPointer(0), upBlock.getChannelPointer(1), (int)upBlock.getNumSamples());
+            oversampler.processSamplesDown(subBlock);
+        }
+
+        return output;
+    }
+
+    //==============================================================================
+    /** Raw doubles behind a small header; false if the file cannot be written. */
+    bool writeGolden(const juce::File& file, const juce::AudioBuffer<double>& output, double sampleRate)
+    {
+        file.deleteFile();
+        juce::FileOutputStream stream(file);
+        if (!stream.openedOk()) return false;
+
+        stream.writeInt(goldenMagic);
+        stream.writeDouble(sampleRate);
+        stream.writeInt(output.getNumChannels());
+        stream.writeInt(output.getNumSamples());
+
+        for (int channel = 0; channel < output.getNumChannels(); ++channel)
+            for (int i = 0; i < output.getNumSamples(); ++i)
+                stream.writeDouble(output.getSample(channel, i));
+
+        stream.flush();
+        return stream.getStatus().wasOk();
+    }
+
+    /** Fills golden (already sized) from a file written by writeGolden(); false if the
+        file is missing or was written for another sample rate or length. */
+    bool readGolden(const juce::File& file, double sampleRate, juce::AudioBuffer<double>& golden)
+    {
+        juce::FileInputStream stream(file);
+        if (!stream.openedOk()) return false;
+
+        const juce::int64 expectedLength = 20 + 8 * (juce::int64)golden.getNumChannels() * golden.getNumSamples();
+        if (stream.getTotalLength() != expectedLength
+         || stream.readInt() != goldenMagic
+         || stream.readDouble() != sampleRate
+         || stream.readInt() != golden.getNumChannels()
+         || stream.readInt() != golden.getNumSamples())
+            return false;
+
+        for (int channel = 0; channel < golden.getNumChannels(); ++channel)
+            for (int i = 0; i < golden.getNumSamples(); ++i)
+                golden.setSample(channel, i, stream.readDouble());
+
+        return true;
+    }
+
+    //==============================================================================
+    /** Returns the number of variants that failed. */
+    int runAll(const Options& options)
+    {
+        const int numSamples = juce::roundToInt(options.seconds * options.sampleRate);
+        const bool isWriting = options.writeGolden != juce::File();
+        const bool isComparing = options.compareGolden != juce::File();
+
+        if (isWriting && !options.writeGolden.createDirectory().wasOk()){
+            std::cerr << "Cannot create " << options.writeGolden.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        //Each signal as generated, and rounded to float for the float runs so both sides see the same input
+        juce::OwnedArray<juce::AudioBuffer<double>> doubleInputs, floatInputs;
+        for (int kind = 0; kind < TestSignals::numKinds; ++kind){
+            auto* input = doubleInputs.add(new juce::AudioBuffer<double>(2, numSamples));
+            TestSignals::generate((TestSignals::Kind)kind, *input, options.sampleRate);
+
+            auto* rounded = floatInputs.add(new juce::AudioBuffer<double>(*input));
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    rounded->setSample(channel, i, (double)(float)rounded->getSample(channel, i));
+        }
+
+        std::cout << "LPanner differential test, " << options.sampleRate << " Hz, " << options.seconds << " s per run" << std::endl
+                  << "Tolerance float " << options.floatTolerance << " dB, double " << options.doubleTolerance
+                  << " dB below the reference peak; stages W width, R rotation, L LPF-Link" << std::endl << std::endl;
+
+        int numFailed = 0;
+        const auto variants = makeVariants();
+
+        for (const auto& variant : variants){
+            const double tolerance = variant.doublePrecision ? options.doubleTolerance : options.floatTolerance;
+            double worst = exactDecibels, worstGolden = exactDecibels;
+            bool goldenOk = true;
+
+            for (int set = 0; set < juce::numElementsInArray(parameterSets); ++set){
+                for (int kind = 0; kind < TestSignals::numKinds; ++kind){
+                    const auto& input = *(variant.doublePrecision ? doubleInputs : floatInputs)[kind];
+                    const auto expected = renderReference(variant, parameterSets[set], input, options.sampleRate);
+
+                    for (auto blockSize : options.blockSizes){
+                        const auto output = variant.doublePrecision
+                                          ? renderProcessor<double>(variant, parameterSets[set], input, blockSize, options.sampleRate)
+                                          : renderProcessor<float>(variant, parameterSets[set], input, blockSize, options.sampleRate);
+
+                        const double decibels = measure(output, expected).getDecibels();
+                        worst = juce::jmax(worst, decibels);
+
+                        const auto key = getRunKey(variant, blockSize, (TestSignals::Kind)kind, set);
+                        juce::String goldenResult;
+
+                        if (isWriting && !writeGolden(options.writeGolden.getChildFile(key + ".golden"), output, options.sampleRate)){
+                            std::cerr << "Cannot write golden file " << key << std::endl;
+                            goldenOk = false;
+                        }
+
+                        if (isComparing){
+                            juce::AudioBuffer<double> golden(2, numSamples);
+                            if (readGolden(options.compareGolden.getChildFile(key + ".golden"), options.sampleRate, golden)){
+                                const double goldenDecibels = measure(output, golden).getDecibels();
+                                worstGolden = juce::jmax(worstGolden, goldenDecibels);
+                                goldenResult = "  golden " + formatDecibels(goldenDecibels);
+                            }
+                            else{
+                                goldenOk = false;
+                                goldenResult = "  golden missing";
+                            }
+                        }
+
+                        if (options.verbose)
+                            std::cout << getVariantName(variant) << ("block " + getBlockName(blockSize)).paddedRight(' ', 11)
+                                      << juce::String(TestSignals::getName((TestSignals::Kind)kind)).paddedRight(' ', 10)
+                                      << "set " << set << formatDecibels(decibels).paddedLeft(' ', 12) << goldenResult << std::endl;
+                    }
+                }
+            }
+
+            const bool passed = worst <= tolerance && goldenOk && worstGolden <= tolerance;
+            if (!passed) ++numFailed;
+
+            std::cout << getVariantName(variant) << formatDecibels(worst).paddedLeft(' ', 12)
+                      << (isComparing ? "  golden " + formatDecibels(worstGolden) + (goldenOk ? "" : ", missing files") : juce::String())
+                      << (passed ? "  ok" : "  FAILED") << std::endl;
+        }
+
+        std::cout << std::endl << (int)variants.size() - numFailed << " of " << (int)variants.size() << " variants within tolerance" << std::endl;
+        return numFailed;
+    }
+
+    //==============================================================================
+    /** One automated run: a quality and the features that move the matrix on top of the ramps. */
+    struct AutomationCase
+    {
+        const char* name;
+        Quality quality;
+        bool transientWidth, sidechain, autoRotate, autoWidth;
+    };
+
+    //Standard covers the ramped kernel, the per-sample kernel (transient, sidechain) and
+    //processModulated(); Eco its interval matrices and processModulated() at 64 samples.
+    //High is left to the steady runs, its oversampler makes the ramps a filter question.
+    const AutomationCase automationCases[] =
+    {
+        { "ramp",           Quality::standard, false, false, false, false },
+        { "transient",      Quality::standard, true,  false, false, false },
+        { "sidechain",      Quality::standard, false, true,  false, false },
+        { "sc+transient",   Quality::standard, true,  true,  false, false },
+        { "autorotate",     Quality::standard, false, false, true,  false },
+        { "autorotate+all", Quality::standard, true,  true,  true,  false },
+        { "autowidth",      Quality::standard, false, false, false, true  },
+        { "ramp",           Quality::eco,      false, false, false, false },
+        { "sc+transient",   Quality::eco,      true,  true,  false, false },
+        { "autorotate+all", Quality::eco,      true,  true,  true,  false }
+    };
+
+    /** Parameter values the host set before one block, as the processor read them. */
+    struct AutomatedBlock
+    {
+        int numSamples;
+        double width, rotation, gain;
+    };
+
+    /** Host automation: Width swings through both sides of 50, Rotation both ways, Gain
+        around its default, fast enough that most ramps are cut short by the next target. */
+    void getAutomation(double seconds, double& width, double& rotation, double& gain)
+    {
+        width = 50.0 + 45.0 * std::sin(2.0 * M_PI * 3.0 * seconds);
+        rotation = 80.0 * std::sin(2.0 * M_PI * 2.0 * seconds + 1.0);
+        gain = 0.7 + 0.2 * std::sin(2.0 * M_PI * 1.5 * seconds + 2.0);
+    }
+
+    /** Sidechain for the automation runs: decaying 60 Hz bursts four times a second,
+        so the envelope attacks, releases and crosses the threshold every burst. */
+    void makeSidechain(juce::AudioBuffer<double>& buffer, double sampleRate)
+    {
+        for (int i = 0; i < buffer.getNumSamples(); ++i){
+            const double time = std::fmod(i / sampleRate, 0.25);
+            const double sample = 0.5 * std::exp(-time / 0.04) * std::sin(2.0 * M_PI * 60.0 * time);
+            buffer.setSample(0, i, sample);
+            buffer.setSample(1, i, sample);
+        }
+    }
+
+    /** Runs a fresh processor from its initial state, setting the automation before
+        every block. Fills blocks and settings with what the processor read, for the model. */
+    template <class sampleType>
+    juce::AudioBuffer<double> renderAutomated(const AutomationCase& test, const juce::AudioBuffer<double>& input,
+                                              const juce::AudioBuffer<double>& sidechain, double sampleRate,
+                                              std::vector<AutomatedBlock>& blocks, AutomationModel::Settings& settings)
+    {
+        StereoPanAudioProcessor processor;
+        setParameter(processor, "quality", (double)test.quality);
+        setParameter(processor, "lpflink", 0.0);
+
+        settings = {};
+        settings.path = test.quality == Quality::eco ? AutomationModel::Path::eco : AutomationModel::Path::standard;
+        settings.transientWidth = test.transientWidth;
+        settings.autoRotate = test.autoRotate;
+        settings.autoWidth = test.autoWidth;
+        setParameter(processor, "transientwidth", test.transientWidth ? 1.0 : 0.0);
+        setParameter(processor, "autorotate", test.autoRotate ? 1.0 : 0.0);
+        setParameter(processor, "autowidth", test.autoWidth ? 1.0 : 0.0);
+
+        if (test.sidechain){
+            settings.sidechainWidth = setParameter(processor, "sidechainwidth", -60.0);
+            settings.sidechainRotation = setParameter(processor, "sidechainrotation", 40.0);
+            settings.sidechainThreshold = (float)setParameter(processor, "sidechainthreshold", -30.0);
+            settings.sidechainAttack = setParameter(processor, "sidechainattack", 5.0);
+            settings.sidechainRelease = setParameter(processor, "sidechainrelease", 200.0);
+            processor.enableAllBuses();
+        }
+        if (test.autoRotate){
+            setParameter(processor, "autorotaterate", 2.0);     //1 Bar
+            setParameter(processor, "autorotateshape", 0.0);
+            settings.autoRotateDepth = setParameter(processor, "autorotatedepth", 50.0);
+        }
+        if (test.autoWidth){
+            setParameter(processor, "autowidthmode", 0.0);
+            settings.autoWidthCorrelation = setParameter(processor, "autowidthcorr", 0.5);
+        }
+
+        processor.setProcessingPrecision(std::is_same<sampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                 : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+        processor.prepareToPlay(sampleRate, maxBlockSize);
+
+        //Main bus on channels 0 and 1, the sidechain bus after it
+        const int totalSamples = input.getNumSamples();
+        const int numChannels = test.sidechain ? 4 : 2;
+        juce::AudioBuffer<sampleType> io(numChannels, totalSamples);
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < totalSamples; ++i)
+                io.setSample(channel, i, (sampleType)(channel < 2 ? input : sidechain).getSample(channel % 2, i));
+
+        juce::MidiBuffer midi;
+        juce::Random random(0x426c6b73);
+        blocks.clear();
+
+        for (int start = 0; start < totalSamples; ){
+            AutomatedBlock block;
+            block.numSamples = juce::jmin(1 + random.nextInt(maxBlockSize), totalSamples - start);
+
+            double width, rotation, gain;
+            getAutomation(start / sampleRate, width, rotation, gain);
+            block.width = setParameter(processor, "width", width);
+            block.rotation = setParameter(processor, "rotation", rotation);
+            block.gain = setParameter(processor, "gain", gain);
+            blocks.push_back(block);
+
+            juce::AudioBuffer<sampleType> view(io.getArrayOfWritePointers(), numChannels, start, block.numSamples);
+            processor.processBlock(view, midi);
+            start += block.numSamples;
+        }
+
+        processor.releaseResources();
+
+        juce::AudioBuffer<double> output(2, totalSamples);
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < totalSamples; ++i)
+                output.setSample(channel, i, (double)io.getSample(channel, i));
+
+        return output;
+    }
+
+    juce::AudioBuffer<double> renderAutomationReference(const AutomationModel::Settings& settings, const std::vector<AutomatedBlock>& blocks,
+                                                        const juce::AudioBuffer<double>& input, const juce::AudioBuffer<double>& sidechain,
+                                                        bool useSidechain, double sampleRate)
+    {
+        juce::AudioBuffer<double> output(input);
+        AutomationModel model(settings, sampleRate);
+
+        int start = 0;
+        for (const auto& block : blocks){
+            const double* sidechainChannels[] = { sidechain.getReadPointer(0, start), sidechain.getReadPointer(1, start) };
+            model.processBlock(output.getWritePointer(0, start), output.getWritePointer(1, start),
+                               useSidechain ? sidechainChannels : nullptr, block.numSamples,
+                               block.width, block.rotation, block.gain);
+            start += block.numSamples;
+        }
+
+        return output;
+    }
+
+    /** Every automation case in float and double against AutomationModel, on each
+        test signal in varying block sizes. Returns the number of runs that failed. */
+    int runAutomation(const Options& options)
+    {
+        const int numSamples = juce::roundToInt(options.seconds * options.sampleRate);
+
+        juce::AudioBuffer<double> doubleSidechain(2, numSamples);
+        makeSidechain(doubleSidechain, options.sampleRate);
+
+        //Rounded to float for the float runs, as in runAll()
+        auto roundToFloat = [](juce::AudioBuffer<double> buffer){
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    buffer.setSample(channel, i, (double)(float)buffer.getSample(channel, i));
+            return buffer;
+        };
+        const auto floatSidechain = roundToFloat(doubleSidechain);
+
+        std::cout << std::endl << "Automation, Width, Rotation and Gain set before every block; auto-rotate runs to "
+                  << options.tableTolerance << " dB" << std::endl;
+
+        int numFailed = 0, numRuns = 0;
+
+        for (const auto& test : automationCases){
+            for (int precision = 0; precision < 2; ++precision){
+                const bool isDouble = precision != 0;
+                const double tolerance = test.autoRotate ? options.tableTolerance
+                                       : isDouble ? options.doubleTolerance : options.floatTolerance;
+                const auto& sidechain = isDouble ? doubleSidechain : floatSidechain;
+                double worst = exactDecibels;
+
+                for (int kind = 0; kind < TestSignals::numKinds; ++kind){
+                    juce::AudioBuffer<double> input(2, numSamples);
+                    TestSignals::generate((TestSignals::Kind)kind, input, options.sampleRate);
+                    if (!isDouble)
+                        input = roundToFloat(input);
+
+                    std::vector<AutomatedBlock> blocks;
+                    AutomationModel::Settings settings;
+                    const auto output = isDouble ? renderAutomated<double>(test, input, sidechain, options.sampleRate, blocks, settings)
+                                                 : renderAutomated<float>(test, input, sidechain, options.sampleRate, blocks, settings);
+                    const auto expected = renderAutomationReference(settings, blocks, input, sidechain, test.sidechain, options.sampleRate);
+
+                    const double decibels = measure(output, expected).getDecibels();
+                    worst = juce::jmax(worst, decibels);
+
+                    if (options.verbose)
+                        std::cout << juce::String(isDouble ? "double" : "float").paddedRight(' ', 8)
+                                  << getQualityName(test.quality).paddedRight(' ', 10) << juce::String(test.name).paddedRight(' ', 16)
+                                  << juce::String(TestSignals::getName((TestSignals::Kind)kind)).paddedRight(' ', 10)
+                                  << formatDecibels(decibels).paddedLeft(' ', 12) << std::endl;
+                }
+
+                const bool passed = worst <= tolerance;
+                if (!passed) ++numFailed;
+                ++numRuns;
+
+                std::cout << juce::String(isDouble ? "double" : "float").paddedRight(' ', 8)
+                          << getQualityName(test.quality).paddedRight(' ', 10) << juce::String(test.name).paddedRight(' ', 16)
+                          << formatDecibels(worst).paddedLeft(' ', 12) << (passed ? "  ok" : "  FAILED") << std::endl;
+            }
+        }
+
+        std::cout << std::endl << numRuns - numFailed << " of " << numRuns << " automation runs within tolerance" << std::endl;
+        return numFailed;
+    }
+
+    //==============================================================================
+    /** Writes buffer as a 24-bit stereo WAV; false if the file cannot be written. */
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<double>& buffer, double sampleRate)
+    {
+        juce::AudioBuffer<float> samples(2, buffer.getNumSamples());
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                samples.setSample(channel, i, (float)buffer.getSample(channel, i));
+
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+        if (stream == nullptr) return false;
+
+        juce::WavAudioFormat wavFormat;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), sampleRate, 2, 24, {}, 0));
+        if (writer == nullptr) return false;
+
+        stream.release();   //Owned by the writer now
+        return writer->writeFromAudioSampleBuffer(samples, 0, samples.getNumSamples());
+    }
+
+    /** Reads a whole stereo file into buffer; false if it cannot be read. */
+    bool readWav(const juce::File& file, juce::AudioBuffer<double>& buffer)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr || reader->numChannels != 2) return false;
+
+        juce::AudioBuffer<float> samples(2, (int)reader->lengthInSamples);
+        if (!reader->read(&samples, 0, samples.getNumSamples(), 0, true, true)) return false;
+
+        buffer.setSize(2, samples.getNumSamples());
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < samples.getNumSamples(); ++i)
+                buffer.setSample(channel, i, (double)samples.getSample(channel, i));
+
+        return true;
+    }
+
+    /** Renders every parameter set and stage combination through ParameterSweep::render()
+        and compares each file with ReferenceModel in Standard form. The input goes
+        through a 24-bit WAV and is read back, so both sides see the same samples; the
+        outputs are 24-bit as well, so the float tolerance applies. Returns the number
+        of settings that failed. */
+    int runSweep(const Options& options)
+    {
+        auto folder = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("LPannerSweepTest");
+        folder.deleteRecursively();
+        if (!folder.createDirectory().wasOk()){
+            std::cerr << "Cannot create " << folder.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        //16 settings, so several lane groups run, the last one full
+        std::vector<ParameterSweep::Setting> settings;
+        std::vector<ReferenceModel::Settings> references;
+        for (int set = 0; set < juce::numElementsInArray(parameterSets); ++set){
+            for (int stages = 0; stages < 8; ++stages){
+                ParameterSweep::Setting setting;
+                setting.name = "p" + juce::String(set) + "_" + juce::String(stages);
+                setting.width = (float)parameterSets[set].width;
+                setting.rotation = (float)parameterSets[set].rotation;
+                setting.gain = (float)parameterSets[set].gain;
+                setting.lpfFreq = (float)parameterSets[set].lpfFrequency;
+                setting.widthBypass = (stages & 1) != 0;
+                setting.rotationBypass = (stages & 2) != 0;
+                setting.lpfLink = (stages & 4) == 0;
+                settings.push_back(setting);
+
+                //Same values the sweep sees, after the float rounding of its Setting
+                ReferenceModel::Settings reference;
+                reference.width = setting.width;
+                reference.rotation = setting.rotation;
+                reference.gain = setting.gain;
+                reference.lpfFrequency = setting.lpfFreq;
+                reference.widthBypass = setting.widthBypass;
+                reference.rotationBypass = setting.rotationBypass;
+                reference.lpfLink = setting.lpfLink;
+                references.push_back(reference);
+            }
+        }
+
+        std::cout << std::endl << "ParameterSweep::render(), " << (int)settings.size() << " settings per signal, 24-bit files" << std::endl;
+
+        std::vector<double> worst(settings.size(), exactDecibels);
+        bool filesOk = true;
+        const int numSamples = juce::roundToInt(options.seconds * options.sampleRate);
+
+        for (int kind = 0; kind < TestSignals::numKinds && filesOk; ++kind){
+            juce::AudioBuffer<double> signal(2, numSamples), input;
+            TestSignals::generate((TestSignals::Kind)kind, signal, options.sampleRate);
+
+            const auto inputFile = folder.getChildFile("input.wav");
+            const auto outputFolder = folder.getChildFile(TestSignals::getName((TestSignals::Kind)kind));
+            if (!writeWav(inputFile, signal, options.sampleRate) || !readWav(inputFile, input)){
+                std::cerr << "Cannot write " << inputFile.getFullPathName() << std::endl;
+                filesOk = false;
+                break;
+            }
+
+            //An odd block size, so chunk edges fall inside the LPF-Link filters' memory
+            const auto error = ParameterSweep::render(inputFile, settings, outputFolder, 333);
+            if (error.isNotEmpty()){
+                std::cerr << error << std::endl;
+                filesOk = false;
+                break;
+            }
+
+            for (size_t index = 0; index < settings.size(); ++index){
+                juce::AudioBuffer<double> output;
+                if (!readWav(outputFolder.getChildFile(settings[index].name + ".wav"), output) || output.getNumSamples() != numSamples){
+                    std::cerr << "Missing or short output for " << settings[index].name << std::endl;
+                    filesOk = false;
+                    continue;
+                }
+
+                juce::AudioBuffer<double> expected(input);
+                ReferenceModel model(references[index], options.sampleRate);
+                for (int i = 0; i < numSamples; ++i)
+                    model.processSample(expected.getWritePointer(0)[i], expected.getWritePointer(1)[i]);
+
+                const double decibels = measure(output, expected).getDecibels();
+                worst[index] = juce::jmax(worst[index], decibels);
+
+                if (options.verbose)
+                    std::cout << "sweep   " << settings[index].name.paddedRight(' ', 8)
+                              << juce::String(TestSignals::getName((TestSignals::Kind)kind)).paddedRight(' ', 10)
+                              << formatDecibels(decibels).paddedLeft(' ', 12) << std::endl;
+            }
+        }
+
+        int numFailed = filesOk ? 0 : 1;
+        for (size_t index = 0; index < settings.size(); ++index){
+            const bool passed = worst[index] <= options.floatTolerance;
+            if (!passed) ++numFailed;
+
+            Variant variant;
+            variant.widthBypass = settings[index].widthBypass;
+            variant.rotationBypass = settings[index].rotationBypass;
+            variant.lpfLink = settings[index].lpfLink;
+            std::cout << "sweep   " << ("set " + settings[index].name.substring(1, 2)).paddedRight(' ', 10)
+                      << getStages(variant).paddedRight(' ', 8) << formatDecibels(worst[index]).paddedLeft(' ', 12)
+                      << (passed ? "  ok" : "  FAILED") << std::endl;
+        }
+
+        folder.deleteRecursively();
+        return numFailed;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    //The processor posts latency changes to the message thread
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h")){
+        std::cout << usage;
+        return 0;
+    }
+
+    const auto options = parseOptions(args);
+    const int numFailed = runAll(options) + runAutomation(options) + runSweep(options);
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    ReferenceModel.h
+    Scalar double-precision model of the LPanner stereo path.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "cmath"
+#include "corecrt_math_defines.h"
+
+//==============================================================================
+/** What the stereo path computes for steady parameters, written the slow, obvious
+    way one sample at a time: decode to L/R, width and gain on L + R / L - R, rotate,
+    decode again, then LPF-Link on the channel the image turns away from.
+
+    Nothing is shared with StereoMatrix.h and the formulas are restated from the
+    parameters (cos - sin instead of sqrt(2) sin(pi/4 - x), the cutoff from the
+    Rotation value), so a slip in a kernel, its dispatch or a format shortcut shows
+    up as a difference instead of being repeated on both sides.
+*/
+class ReferenceModel
+{
+public:
+    struct Settings
+    {
+        //Plain parameter values
+        double width = 50.0, rotation = 0.0, gain = 0.7, lpfFrequency = 20000.0;
+        bool widthBypass = false, rotationBypass = false, lpfLink = false;
+        bool msInput = false, msOutput = false;
+
+        //Eco's LPF-Link is a one-pole, the other qualities use a biquad
+        bool onePoleLowPass = false;
+    };
+
+    /** sampleRate is the rate the model runs at, twice the host rate for High. */
+    ReferenceModel(const Settings& s, double sampleRate)
+        : settings(s)
+    {
+        const double Theta_w = s.widthBypass ? 0.0 : M_PI / 200.0 * (s.width - 50.0);
+        const double Theta_r = s.rotationBypass ? 0.0 : -M_PI / 400.0 * s.rotation;
+        const double outputGain = s.gain * s.gain;
+
+        midGain = (std::cos(Theta_w) - std::sin(Theta_w)) * outputGain;
+        sideGain = (std::cos(Theta_w) + std::sin(Theta_w)) * outputGain;
+        cosRotation = std::cos(Theta_r);
+        sinRotation = std::sin(Theta_r);
+
+        //Rotation above 0 filters L, below 0 filters R
+        const double rotationAmount = s.rotationBypass ? 0.0 : s.rotation / 100.0;
+        if (s.lpfLink && rotationAmount != 0.0)
+            lpfSide = rotationAmount > 0.0 ? -1 : 1;
+
+        const double bias = juce::jmin(1.0, std::abs(rotationAmount));
+        const double frequency = 20000.0 + bias * (s.lpfFrequency - 20000.0);
+
+        if (s.onePoleLowPass){
+            onePole = 1.0 - std::exp(-2.0 * M_PI * juce::jmin(frequency, sampleRate * 0.5) / sampleRate);
+        }
+        else{
+            //Bilinear transform of 1 / (s^2 + s / Q + 1)
+            const double Q = 0.7;
+            const double K = std::tan(M_PI * juce::jlimit(1.0, sampleRate * 0.499, frequency) / sampleRate);
+            const double norm = 1.0 / (1.0 + K / Q + K * K);
+            b0 = K * K * norm;
+            b1 = 2.0 * b0;
+            b2 = b0;
+            a1 = 2.0 * (K * K - 1.0) * norm;
+            a2 = (1.0 - K / Q + K * K) * norm;
+        }
+    }
+
+    void processSample(double& first, double& second)
+    {
+        //MS carries M = (L + R) / 2 and S = (L - R) / 2
+        double left = settings.msInput ? first + second : first;
+        double right = settings.msInput ? first - second : second;
+
+        const double mid = (left + right) * midGain;
+        const double side = (left - right) * sideGain;
+
+        const double rotatedMid = cosRotation * mid - sinRotation * side;
+        const double rotatedSide = sinRotation * mid + cosRotation * side;
+
+        left = rotatedMid + rotatedSide;
+        right = rotatedMid - rotatedSide;
+
+        if (lpfSide > 0)
+            right = lowPass(right);
+        else if (lpfSide < 0)
+            left = lowPass(left);
+
+        if (settings.msOutput){
+            first = (left + right) * 0.5;
+            second = (left - right) * 0.5;
+        }
+        else{
+            first = left;
+            second = right;
+        }
+    }
+
+private:
+    double lowPass(double x)
+    {
+        if (settings.onePoleLowPass)
+            return y1 += onePole * (x - y1);
+
+        //Direct form I
+        const double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        return y;
+    }
+
+    Settings settings;
+    double midGain = 1.0, sideGain = 1.0, cosRotation = 1.0, sinRotation = 0.0;
+
+    int lpfSide = 0;
+    double onePole = 1.0;
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+};
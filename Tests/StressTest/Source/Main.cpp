@@ -0,0 +1,516 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Many-instance stress test: LPanner instances in a simulated host mixing graph.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../../../Source/PluginProcessor.h"
+#include "../../Common/TestSignals.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment(lib, "psapi.lib")
+#elif JUCE_MAC
+ #include <mach/mach.h>
+ #include <sys/sysctl.h>
+#elif JUCE_LINUX
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+/*  Creates N processors, spreads them over tracks and runs the tracks on a worker pool
+    once per block period, the way a host's audio graph does, for every N in turn.
+    Per N it reports the memory each instance costs, the cost of one block on a single
+    core with all N cycling through its caches, how long the graph took against the
+    block deadline and how many instances one fully busy core sustains in real time.
+*/
+namespace
+{
+    const char* const usage =
+        "Usage: LPannerStressTest [options]\n"
+        "  --instances=<list>      instance counts, run in ascending order, default 1,8,32,64,128,256,500\n"
+        "  --threads=<n>           audio threads including the scheduler, default one per logical core\n"
+        "  --chain=<n>             instances in series on each track, default 1\n"
+        "  --sample-rate=<Hz>      default 48000\n"
+        "  --block-size=<n>        default 256\n"
+        "  --seconds=<s>           audio simulated per instance count, default 5\n"
+        "  --deadline=<fraction>   share of the block period the graph may take, default 1\n"
+        "  --quality=<q>           eco, standard, high or mixed, default standard\n"
+        "  --no-automation         keep Width and Rotation still instead of automating them every block\n"
+        "  --freewheel             start each block as soon as the previous one is done\n"
+        "  --l1-kb=<n>, --l2-kb=<n>  per-core data cache sizes when they cannot be detected\n";
+
+    struct Options
+    {
+        juce::Array<int> instanceCounts { 1, 8, 32, 64, 128, 256, 500 };
+        int numThreads = juce::SystemStats::getNumCpus();
+        int chainLength = 1;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        double seconds = 5.0;
+        double deadline = 1.0;
+        int quality = 1;            //Choice index of the "quality" parameter, -1 for a mix of all three
+        bool automate = true;
+        bool freewheel = false;
+        int l1Bytes = 0, l2Bytes = 0;
+    };
+
+    Options parseOptions(const juce::ArgumentList& args)
+    {
+        Options options;
+        auto value = [&args](const char* option){ return args.getValueForOption(option); };
+
+        if (value("--instances").isNotEmpty()){
+            options.instanceCounts.clear();
+            for (auto& count : juce::StringArray::fromTokens(value("--instances"), ",", ""))
+                if (count.trim().getIntValue() > 0)
+                    options.instanceCounts.addIfNotAlreadyThere(count.trim().getIntValue());
+        }
+        options.instanceCounts.sort();      //Memory per instance relies on the counts only growing
+
+        if (value("--threads").isNotEmpty())
+            options.numThreads = juce::jmax(1, value("--threads").getIntValue());
+        if (value("--chain").isNotEmpty())
+            options.chainLength = juce::jmax(1, value("--chain").getIntValue());
+        if (value("--sample-rate").isNotEmpty())
+            options.sampleRate = juce::jmax(8000.0, value("--sample-rate").getDoubleValue());
+        if (value("--block-size").isNotEmpty())
+            options.blockSize = juce::jlimit(16, 8192, value("--block-size").getIntValue());
+        if (value("--seconds").isNotEmpty())
+            options.seconds = juce::jmax(0.1, value("--seconds").getDoubleValue());
+        if (value("--deadline").isNotEmpty())
+            options.deadline = juce::jmax(0.01, value("--deadline").getDoubleValue());
+
+        const auto quality = value("--quality").toLowerCase();
+        if (quality == "eco") options.quality = 0;
+        else if (quality == "high") options.quality = 2;
+        else if (quality == "mixed") options.quality = -1;
+
+        options.automate = !args.containsOption("--no-automation");
+        options.freewheel = args.containsOption("--freewheel");
+
+        if (value("--l1-kb").isNotEmpty())
+            options.l1Bytes = value("--l1-kb").getIntValue() * 1024;
+        if (value("--l2-kb").isNotEmpty())
+            options.l2Bytes = value("--l2-kb").getIntValue() * 1024;
+
+        return options;
+    }
+
+    //==============================================================================
+    /** Memory the process holds: private commit on Windows, resident set elsewhere. */
+    juce::int64 getProcessMemory()
+    {
+       #if JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS_EX counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters)))
+            return (juce::int64)counters.PrivateUsage;
+       #elif JUCE_MAC
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+            return (juce::int64)info.resident_size;
+       #elif JUCE_LINUX
+        //Second field: resident pages
+        auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), " ", "");
+        if (fields.size() > 1)
+            return fields[1].getLargeIntValue() * (juce::int64)sysconf(_SC_PAGESIZE);
+       #endif
+        return 0;
+    }
+
+    /** Per-core L1 and L2 data cache sizes; leaves a size alone where the platform does not tell. */
+    void detectCacheSizes(int& l1, int& l2)
+    {
+       #if JUCE_WINDOWS
+        DWORD length = 0;
+        GetLogicalProcessorInformation(nullptr, &length);
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        if (!info.empty() && GetLogicalProcessorInformation(info.data(), &length))
+            for (const auto& entry : info)
+                if (entry.Relationship == RelationCache && entry.Cache.Type != CacheInstruction){
+                    if (entry.Cache.Level == 1) l1 = (int)entry.Cache.Size;
+                    if (entry.Cache.Level == 2) l2 = (int)entry.Cache.Size;
+                }
+       #elif JUCE_MAC
+        juce::int64 size = 0;
+        size_t length = sizeof(size);
+        if (sysctlbyname("hw.l1dcachesize", &size, &length, nullptr, 0) == 0) l1 = (int)size;
+        length = sizeof(size);
+        if (sysctlbyname("hw.l2cachesize", &size, &length, nullptr, 0) == 0) l2 = (int)size;
+       #elif JUCE_LINUX
+        for (int index = 0; index < 8; ++index){
+            auto folder = juce::File("/sys/devices/system/cpu/cpu0/cache/index" + juce::String(index));
+            if (!folder.isDirectory()) break;
+            if (folder.getChildFile("type").loadFileAsString().trim() == "Instruction") continue;
+
+            //"48K", "2048K" or "2M"
+            const auto text = folder.getChildFile("size").loadFileAsString().trim();
+            const int size = text.getIntValue() * (text.endsWithChar('M') ? 1024 * 1024 : 1024);
+            const int level = folder.getChildFile("level").loadFileAsString().getIntValue();
+            if (level == 1) l1 = size;
+            if (level == 2) l2 = size;
+        }
+       #else
+        juce::ignoreUnused(l1, l2);
+       #endif
+    }
+
+    /** Rough bytes one instance touches every block: the processor object, its block of
+        track audio and, for High, the double-precision and 2x oversampled copies.
+        Parameter objects and idle features are left out. This is a size estimate, not a
+        measured cache footprint; the table labels it as such. */
+    int estimateHotBytes(int quality, int blockSize)
+    {
+        if (quality < 0)
+            return (estimateHotBytes(0, blockSize) + estimateHotBytes(1, blockSize) + estimateHotBytes(2, blockSize)) / 3;
+
+        int bytes = (int)sizeof(StereoPanAudioProcessor) + 2 * blockSize * (int)sizeof(float);
+        if (quality == 2)
+            bytes += 2 * blockSize * (int)sizeof(double) + 2 * 2 * blockSize * (int)sizeof(double);
+        return bytes;
+    }
+
+    //==============================================================================
+    juce::RangedAudioParameter* findParameter(juce::AudioProcessor& processor, const juce::String& parameterID)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                if (ranged->paramID == parameterID)
+                    return ranged;
+
+        std::cerr << "Unknown parameter " << parameterID << std::endl;
+        jassertfalse;
+        return nullptr;
+    }
+
+    void setParameter(juce::AudioProcessor& processor, const juce::String& parameterID, double value)
+    {
+        if (auto* parameter = findParameter(processor, parameterID))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1((float)value));
+    }
+
+    //==============================================================================
+    /** Host-style audio worker pool. Every block the scheduler wakes the workers, then all
+        of them, scheduler included, take tracks off one shared counter until none are
+        left; the last one to finish wakes the scheduler if it is still waiting. */
+    class GraphPool
+    {
+    public:
+        GraphPool(int numThreads, std::function<void(int)> processTrackToUse)
+            : processTrack(std::move(processTrackToUse)),
+              busyTicks((size_t)numThreads, 0)
+        {
+            for (int i = 1; i < numThreads; ++i){
+                workers.emplace_back(new Worker(*this, i));
+                workers.back()->startThread(juce::Thread::realtimeAudioPriority);
+            }
+        }
+
+        ~GraphPool()
+        {
+            for (auto& worker : workers)
+                worker->signalThreadShouldExit();
+            for (auto& worker : workers){
+                worker->start.signal();
+                worker->stopThread(2000);
+            }
+        }
+
+        /** Processes every track once, on the calling thread and the workers. */
+        void run(int numTracksToRun)
+        {
+            numTracks = numTracksToRun;
+            nextTrack.store(0, std::memory_order_relaxed);
+            remaining.store((int)workers.size() + 1, std::memory_order_release);
+
+            for (auto& worker : workers)
+                worker->start.signal();
+
+            drain(0);
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                done.wait(-1);
+        }
+
+        /** Time every thread spent on tracks since construction, summed. */
+        double getBusySeconds() const
+        {
+            juce::int64 total = 0;
+            for (auto ticks : busyTicks)
+                total += ticks;
+            return juce::Time::highResolutionTicksToSeconds(total);
+        }
+
+    private:
+        struct Worker : public juce::Thread
+        {
+            Worker(GraphPool& owner, int threadIndex)
+                : juce::Thread("LPanner stress worker " + juce::String(threadIndex)), pool(owner), index(threadIndex) {}
+
+            void run() override
+            {
+                while (!threadShouldExit()){
+                    if (!start.wait(100) || threadShouldExit()) continue;
+
+                    pool.drain(index);
+                    if (pool.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        pool.done.signal();
+                }
+            }
+
+            GraphPool& pool;
+            const int index;
+            juce::WaitableEvent start;
+        };
+
+        void drain(int thread)
+        {
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            for (int track; (track = nextTrack.fetch_add(1, std::memory_order_relaxed)) < numTracks; )
+                processTrack(track);
+            busyTicks[(size_t)thread] += juce::Time::getHighResolutionTicks() - startTicks;
+        }
+
+        std::function<void(int)> processTrack;
+        std::vector<juce::int64> busyTicks;     //One slot per thread, read once the block is done
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        int numTracks = 0;
+        std::atomic<int> nextTrack { 0 };
+        std::atomic<int> remaining { 0 };
+        juce::WaitableEvent done;
+    };
+
+    /** Yields instead of sleeping so the block starts on time; a sleep can overshoot by a whole timer tick. */
+    void waitUntil(juce::int64 ticks)
+    {
+        while (juce::Time::getHighResolutionTicks() < ticks)
+            juce::Thread::yield();
+    }
+
+    //==============================================================================
+    struct Instance
+    {
+        std::unique_ptr<StereoPanAudioProcessor> processor;
+        juce::RangedAudioParameter* width = nullptr;
+        juce::RangedAudioParameter* rotation = nullptr;
+    };
+
+    struct Track
+    {
+        std::vector<Instance*> chain;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+        int readPosition = 0;
+    };
+
+    struct Result
+    {
+        double bytesPerInstance = 0.0;
+        double microsecondsPerBlock = 0.0;      //One core, all instances in turn
+        double median = 0.0, percentile99 = 0.0, worst = 0.0;   //Graph time over the block period
+        int numMisses = 0, numBlocks = 0;
+        double realtimePerCore = 0.0;           //Instances one fully busy core sustains
+        double load = 0.0;                      //Busy share of all audio threads
+    };
+
+    Result runGraph(int numInstances, const Options& options, const juce::AudioBuffer<float>& noise, juce::int64 baselineMemory)
+    {
+        Result result;
+
+        //Created and prepared as a host loads a session
+        std::vector<Instance> instances((size_t)numInstances);
+        for (int i = 0; i < numInstances; ++i){
+            auto& instance = instances[(size_t)i];
+            instance.processor.reset(new StereoPanAudioProcessor());
+            auto& processor = *instance.processor;
+
+            setParameter(processor, "quality", options.quality >= 0 ? options.quality : i % 3);
+            setParameter(processor, "width", 70.0);
+            setParameter(processor, "rotation", 30.0);
+            setParameter(processor, "lpflink", 1.0);
+            instance.width = findParameter(processor, "width");
+            instance.rotation = findParameter(processor, "rotation");
+
+            processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+            processor.prepareToPlay(options.sampleRate, options.blockSize);
+        }
+
+        //Counts only grow, so freed memory of the last run is reused before the process grows
+        result.bytesPerInstance = (double)(getProcessMemory() - baselineMemory) / numInstances;
+
+        const int numTracks = (numInstances + options.chainLength - 1) / options.chainLength;
+        std::vector<Track> tracks((size_t)numTracks);
+        for (int i = 0; i < numInstances; ++i)
+            tracks[(size_t)(i / options.chainLength)].chain.push_back(&instances[(size_t)i]);
+        for (int t = 0; t < numTracks; ++t){
+            tracks[(size_t)t].buffer.setSize(2, options.blockSize);
+            tracks[(size_t)t].readPosition = (t * 7 * options.blockSize) % noise.getNumSamples();
+        }
+
+        int block = 0;      //Written by the scheduler between blocks only
+        auto processTrack = [&](int index){
+            auto& track = tracks[(size_t)index];
+
+            //The host reads the track's audio, then runs its inserts in series
+            for (int channel = 0; channel < 2; ++channel)
+                track.buffer.copyFrom(channel, 0, noise, channel, track.readPosition, options.blockSize);
+            track.readPosition = (track.readPosition + options.blockSize) % noise.getNumSamples();
+
+            for (auto* instance : track.chain){
+                if (options.automate){
+                    //Slow automation at a different phase per track, so the ramps never rest
+                    const double phase = block * options.blockSize / options.sampleRate * 0.5 + index * 0.37;
+                    instance->width->setValueNotifyingHost(instance->width->convertTo0to1((float)(50.0 + 30.0 * std::sin(phase))));
+                    instance->rotation->setValueNotifyingHost(instance->rotation->convertTo0to1((float)(40.0 * std::sin(0.7 * phase))));
+                }
+                instance->processor->processBlock(track.buffer, track.midi);
+            }
+        };
+
+        //The first block adopts the prepared state; then one core runs every instance in turn,
+        //so the cost per block climbs once their working sets stop fitting its caches together
+        for (int t = 0; t < numTracks; ++t)
+            processTrack(t);
+        ++block;
+
+        const int sweepRounds = 8;
+        const auto sweepStart = juce::Time::getHighResolutionTicks();
+        for (int round = 0; round < sweepRounds; ++round, ++block)
+            for (int t = 0; t < numTracks; ++t)
+                processTrack(t);
+        result.microsecondsPerBlock = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - sweepStart)
+                                    * 1.0e6 / (sweepRounds * numInstances);
+
+        //The graph, one device callback per block period
+        GraphPool pool(options.numThreads, processTrack);
+        const double period = options.blockSize / options.sampleRate;
+        const double ticksPerSecond = (double)juce::Time::getHighResolutionTicksPerSecond();
+        result.numBlocks = juce::jmax(1, juce::roundToInt(options.seconds / period));
+
+        std::vector<double> graphTimes;
+        graphTimes.reserve((size_t)result.numBlocks);
+
+        const auto graphStart = juce::Time::getHighResolutionTicks();
+        for (int n = 0; n < result.numBlocks; ++n, ++block){
+            //Callbacks keep their schedule even after a late block, as a device does
+            auto scheduled = graphStart + (juce::int64)(n * period * ticksPerSecond);
+            if (options.freewheel)
+                scheduled = juce::Time::getHighResolutionTicks();
+            else
+                waitUntil(scheduled);
+
+            pool.run(numTracks);
+
+            const double elapsed = (juce::Time::getHighResolutionTicks() - scheduled) / ticksPerSecond;
+            graphTimes.push_back(elapsed / period);
+            if (elapsed > options.deadline * period)
+                ++result.numMisses;
+        }
+        const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - graphStart);
+
+        std::sort(graphTimes.begin(), graphTimes.end());
+        result.median = graphTimes[graphTimes.size() / 2];
+        result.percentile99 = graphTimes[juce::jmin(graphTimes.size() - 1, (size_t)(graphTimes.size() * 0.99))];
+        result.worst = graphTimes.back();
+
+        const double busySeconds = pool.getBusySeconds();
+        const double audioSeconds = result.numBlocks * period * numInstances;
+        result.realtimePerCore = busySeconds > 0.0 ? audioSeconds / busySeconds : 0.0;
+        result.load = busySeconds / (wallSeconds * options.numThreads);
+
+        for (auto& instance : instances)
+            instance.processor->releaseResources();
+
+        return result;
+    }
+
+    juce::String formatPercent(double fraction)
+    {
+        return juce::String(fraction * 100.0, 0) + "%";
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    //The processors post latency changes to the message thread
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h")){
+        std::cout << usage;
+        return 0;
+    }
+
+    auto options = parseOptions(args);
+
+    int l1 = 32 * 1024, l2 = 512 * 1024;
+    detectCacheSizes(l1, l2);
+    if (options.l1Bytes > 0) l1 = options.l1Bytes;
+    if (options.l2Bytes > 0) l2 = options.l2Bytes;
+
+    //One second of noise, a whole number of blocks long; every track reads from its own position
+    const int noiseLength = options.blockSize * juce::jmax(1, juce::roundToInt(options.sampleRate / options.blockSize));
+    juce::AudioBuffer<double> generated(2, noiseLength);
+    TestSignals::generate(TestSignals::Kind::noise, generated, options.sampleRate);
+    juce::AudioBuffer<float> noise;
+    noise.makeCopyOf(generated);
+
+    const auto baselineMemory = getProcessMemory();
+    const int hotBytes = estimateHotBytes(options.quality, options.blockSize);
+    const char* qualityNames[] = { "mixed", "Eco", "Standard", "High" };
+
+    std::cout << "LPanner stress test, " << options.numThreads << " audio threads, " << options.blockSize << " samples at "
+              << options.sampleRate << " Hz (" << juce::String(1000.0 * options.blockSize / options.sampleRate, 2) << " ms period)" << std::endl
+              << "Quality " << qualityNames[options.quality + 1] << ", " << options.chainLength << " instance(s) per track, "
+              << (options.automate ? "automated" : "static") << ", deadline " << formatPercent(options.deadline) << " of the period"
+              << (options.freewheel ? ", freewheeling" : "") << std::endl
+              << "sizeof(StereoPanAudioProcessor) " << (int)sizeof(StereoPanAudioProcessor) << " bytes, estimated hot set "
+              << juce::String(hotBytes / 1024.0, 1) << " KB per instance; L1 " << l1 / 1024 << " KB, L2 " << l2 / 1024 << " KB per core" << std::endl
+              << std::endl
+              << "instances   KB/inst   est. hot/worker KB    us/block 1 core   graph p50   p99   worst    misses          rt/core   load" << std::endl;
+
+    for (auto numInstances : options.instanceCounts){
+        const auto r = runGraph(numInstances, options, noise, baselineMemory);
+
+        //Instances one core of the graph cycles through each block
+        const int perWorker = (numInstances + options.numThreads - 1) / options.numThreads;
+        const double hotPerWorker = (double)perWorker * hotBytes;
+        const char* fit = hotPerWorker <= l1 ? "L1" : hotPerWorker <= l2 ? "L2" : ">L2";
+
+        std::cout << juce::String(numInstances).paddedLeft(' ', 9)
+                  << juce::String(r.bytesPerInstance / 1024.0, 1).paddedLeft(' ', 10)
+                  << (juce::String(hotPerWorker / 1024.0, 1) + " " + fit).paddedLeft(' ', 21)
+                  << juce::String(r.microsecondsPerBlock, 2).paddedLeft(' ', 20)
+                  << formatPercent(r.median).paddedLeft(' ', 12)
+                  << formatPercent(r.percentile99).paddedLeft(' ', 6)
+                  << formatPercent(r.worst).paddedLeft(' ', 8)
+                  << (juce::String(r.numMisses) + " (" + juce::String(100.0 * r.numMisses / r.numBlocks, 1) + "%)").paddedLeft(' ', 16)
+                  << juce::String(r.realtimePerCore, 1).paddedLeft(' ', 11)
+                  << formatPercent(r.load).paddedLeft(' ', 7) << std::endl;
+    }
+
+    std::cout << std::endl
+              << "KB/inst: process memory growth per instance." << std::endl
+              << "est. hot/worker: estimated, not measured. sizeof the processor plus its block buffers, times the instances one" << std::endl
+              << "audio thread cycles per block, against the L1/L2 sizes. Use hardware cache counters for the real footprint." << std::endl
+              << "graph: time from the scheduled callback to the last track, over the block period." << std::endl
+              << "rt/core: instances one fully busy core keeps in real time. load: busy share of all audio threads." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Command-line stereo-field audit of an audio folder.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <thread>
+#include "../../../Source/StereoFieldAnalyzer.h"
+
+//==============================================================================
+/*  The editor's Audit button without a DAW: walks a folder, analyses every audio
+    file with StereoFieldAnalyzer and writes the same CSV and JSON reports, so a
+    library can be checked from a script or a build server.
+*/
+namespace
+{
+    const char* const usage =
+        "Usage: LPannerFieldAudit <folder> [options]\n"
+        "  --csv=<file>                default <folder>/LPanner-audit.csv\n"
+        "  --json=<file>               default <folder>/LPanner-audit.json\n"
+        "  --section-seconds=<s>       length of the per-section rows, default 10\n"
+        "  --target-side-mid=<ratio>   side/mid the suggested Width aims for, default 0.25\n"
+        "  --threads=<n>               files analysed at once, default all cores\n"
+        "Returns 0 when every file was read and both reports were written,\n"
+        "1 when a report could not be written, 2 when some files were unreadable.\n";
+
+    struct Options
+    {
+        juce::File folder, csv, json;
+        StereoFieldAnalyzer::Settings settings;
+        int numThreads = 0;
+    };
+
+    bool parseOptions(const juce::ArgumentList& args, Options& options)
+    {
+        auto cwd = juce::File::getCurrentWorkingDirectory();
+        auto value = [&args](const char* option){ return args.getValueForOption(option); };
+
+        for (const auto& argument : args.arguments)
+            if (!argument.isOption())
+                options.folder = cwd.getChildFile(argument.text);
+
+        if (!options.folder.isDirectory()){
+            std::cerr << (options.folder == juce::File() ? juce::String("No folder given")
+                                                         : "Not a folder: " + options.folder.getFullPathName()) << std::endl;
+            return false;
+        }
+
+        options.csv = value("--csv").isNotEmpty() ? cwd.getChildFile(value("--csv"))
+                                                  : options.folder.getChildFile(StereoFieldAnalyzer::csvFileName);
+        options.json = value("--json").isNotEmpty() ? cwd.getChildFile(value("--json"))
+                                                    : options.folder.getChildFile(StereoFieldAnalyzer::jsonFileName);
+
+        if (value("--section-seconds").isNotEmpty())
+            options.settings.sectionSeconds = juce::jmax(0.1, value("--section-seconds").getDoubleValue());
+        if (value("--target-side-mid").isNotEmpty())
+            options.settings.targetSideMid = juce::jmax(0.0, value("--target-side-mid").getDoubleValue());
+        if (value("--threads").isNotEmpty())
+            options.numThreads = juce::jmax(0, value("--threads").getIntValue());
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h")){
+        std::cout << usage;
+        return 0;
+    }
+
+    Options options;
+    if (!parseOptions(args, options)){
+        std::cerr << usage;
+        return 1;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    const auto files = StereoFieldAnalyzer::findAudioFiles(options.folder, formatManager);
+    std::cout << "Auditing " << files.size() << " files below " << options.folder.getFullPathName() << std::endl;
+
+    //Progress on this thread while the pool works through the files
+    std::atomic<int> filesDone { 0 };
+    std::vector<StereoFieldAnalyzer::FileReport> reports;
+    std::thread analysis([&]{ reports = StereoFieldAnalyzer::analyseFiles(files, options.settings, filesDone, nullptr, options.numThreads); });
+
+    for (int shown = 0; shown < files.size(); ){
+        juce::Thread::sleep(200);
+        if (filesDone.load() != shown){
+            shown = filesDone.load();
+            std::cout << "\r" << shown << " / " << files.size() << std::flush;
+        }
+    }
+    analysis.join();
+    std::cout << std::endl;
+
+    int failed = 0;
+    for (const auto& report : reports){
+        if (report.error.isEmpty()) continue;
+        std::cerr << report.file.getFullPathName() << ": " << report.error << std::endl;
+        ++failed;
+    }
+
+    if (!StereoFieldAnalyzer::writeCSV(reports, options.settings, options.csv)
+     || !StereoFieldAnalyzer::writeJSON(reports, options.settings, options.json)){
+        std::cerr << "Could not write " << options.csv.getFullPathName() << " and " << options.json.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Audited " << files.size() - failed << " files into " << options.csv.getFullPathName()
+              << " and " << options.json.getFullPathName();
+    if (failed > 0)
+        std::cout << " (" << failed << " unreadable)";
+    std::cout << std::endl;
+
+    return failed > 0 ? 2 : 0;
+}
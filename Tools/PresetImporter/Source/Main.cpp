@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Builds an LPanner preset library from a folder of state snapshots.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/PluginProcessor.h"
+
+//==============================================================================
+/*  Walks a folder of state XML files as getStateInformation() writes them and
+    packs them into one .lpp library for PresetLibrary. Each snapshot is applied
+    to a processor on top of the defaults, so states saved by older builds get
+    today's values for the parameters they lack, then taken back with
+    capturePreset(). The subfolders a file sits in become its tags.
+*/
+namespace
+{
+    const char* const usage =
+        "Usage: LPannerPresetImporter <folder> [options]\n"
+        "  --output=<file>             default <folder>/<folder name>.lpp\n"
+        "  --tags=<list>               comma separated tags added to every preset\n"
+        "  --no-folder-tags            do not tag presets with their subfolder names\n"
+        "Every *.xml below the folder is read; the file name becomes the preset name.\n"
+        "Returns 0 when every file was imported, 1 when the library could not be\n"
+        "written, 2 when some files were skipped.\n";
+
+    struct Options
+    {
+        juce::File folder, output;
+        juce::StringArray tags;
+        bool folderTags = true;
+    };
+
+    bool parseOptions(const juce::ArgumentList& args, Options& options)
+    {
+        auto cwd = juce::File::getCurrentWorkingDirectory();
+        auto value = [&args](const char* option){ return args.getValueForOption(option); };
+
+        for (const auto& argument : args.arguments)
+            if (!argument.isOption())
+                options.folder = cwd.getChildFile(argument.text);
+
+        if (!options.folder.isDirectory()){
+            std::cerr << (options.folder == juce::File() ? juce::String("No folder given")
+                                                         : "Not a folder: " + options.folder.getFullPathName()) << std::endl;
+            return false;
+        }
+
+        options.output = value("--output").isNotEmpty() ? cwd.getChildFile(value("--output"))
+                                                        : options.folder.getChildFile(options.folder.getFileName() + ".lpp");
+
+        for (auto& tag : juce::StringArray::fromTokens(value("--tags"), ",", ""))
+            if (tag.trim().isNotEmpty())
+                options.tags.addIfNotAlreadyThere(tag.trim(), true);
+
+        options.folderTags = !args.containsOption("--no-folder-tags");
+        return true;
+    }
+
+    /** Sets every parameter to its default, then to the PARAM values state holds. */
+    void applyState(StereoPanAudioProcessor& processor, const juce::XmlElement& state)
+    {
+        for (auto* parameter : processor.getParameters())
+            parameter->setValueNotifyingHost(parameter->getDefaultValue());
+
+        for (auto* param = state.getChildByName("PARAM"); param != nullptr; param = param->getNextElementWithTagName("PARAM"))
+            for (auto* parameter : processor.getParameters())
+                if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                    if (ranged->paramID == param->getStringAttribute("id"))
+                        ranged->setValueNotifyingHost(ranged->convertTo0to1((float)param->getDoubleAttribute("value")));
+    }
+
+    /** name, or name 2, name 3... whichever no earlier preset has, ignoring case. */
+    juce::String makeUniqueName(const juce::String& name, const juce::StringArray& usedNames)
+    {
+        juce::String unique = name;
+        for (int n = 2; usedNames.contains(unique, true); ++n)
+            unique = name + " " + juce::String(n);
+        return unique;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    //The processor posts latency changes to the message thread
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h")){
+        std::cout << usage;
+        return 0;
+    }
+
+    Options options;
+    if (!parseOptions(args, options)){
+        std::cerr << usage;
+        return 1;
+    }
+
+    //Sorted by path so the same folder always gives the same library
+    auto files = options.folder.findChildFiles(juce::File::findFiles, true, "*.xml");
+    std::sort(files.begin(), files.end(), [&options](const juce::File& a, const juce::File& b){
+        return a.getRelativePathFrom(options.folder).compareNatural(b.getRelativePathFrom(options.folder)) < 0;
+    });
+
+    StereoPanAudioProcessor processor;
+    const auto parameterIDs = processor.getParameterIDs();
+    const juce::String stateTag = "StereoPan";     //AudioProcessorValueTreeState type of the processor's state
+
+    std::vector<PresetLibrary::Entry> entries;
+    juce::StringArray usedNames;
+    int skipped = 0;
+
+    for (const auto& file : files){
+        auto xml = juce::parseXML(file);
+        if (xml == nullptr || !xml->hasTagName(stateTag) || xml->getChildByName("PARAM") == nullptr){
+            std::cerr << file.getFullPathName() << ": not an LPanner state" << std::endl;
+            ++skipped;
+            continue;
+        }
+
+        auto tags = options.tags;
+        if (options.folderTags)
+            for (auto parent = file.getParentDirectory(); parent != options.folder && parent.isAChildOf(options.folder); parent = parent.getParentDirectory())
+                tags.insert(0, parent.getFileName());
+
+        const auto name = makeUniqueName(file.getFileNameWithoutExtension(), usedNames);
+        usedNames.add(name);
+
+        applyState(processor, *xml);
+        entries.push_back(processor.capturePreset(name, tags));
+    }
+
+    if (entries.empty()){
+        std::cerr << "No LPanner states below " << options.folder.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    const auto error = PresetLibrary::write(options.output, parameterIDs, entries);
+    if (error.isNotEmpty()){
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << (int)entries.size() << " presets to " << options.output.getFullPathName();
+    if (skipped > 0)
+        std::cout << " (" << skipped << " files skipped)";
+    std::cout << std::endl;
+
+    return skipped > 0 ? 2 : 0;
+}
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Command-line ParameterSweep renderer.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/ParameterSweep.h"
+
+//==============================================================================
+/*  Renders one input file through every setting of a JSON list with
+    ParameterSweep::render(), one WAV per setting, so a batch of mix variants
+    can be made from a script without opening a host.
+*/
+namespace
+{
+    const char* const usage =
+        "Usage: LPannerSweep <input> <settings.json> [options]\n"
+        "  --output=<folder>           default <input name>-sweep next to the input\n"
+        "  --block-size=<n>            samples read per chunk, default 8192\n"
+        "settings.json is an array of objects with the keys name, gain, width, rotation,\n"
+        "lpffreq, widthbypass, rotationbypass and lpflink; missing keys keep the defaults.\n"
+        "Returns 0 when every file was written, 1 otherwise.\n";
+
+    struct Options
+    {
+        juce::File input, settings, output;
+        int blockSize = 8192;
+    };
+
+    bool parseOptions(const juce::ArgumentList& args, Options& options)
+    {
+        auto cwd = juce::File::getCurrentWorkingDirectory();
+        auto value = [&args](const char* option){ return args.getValueForOption(option); };
+
+        juce::StringArray files;
+        for (const auto& argument : args.arguments)
+            if (!argument.isOption())
+                files.add(argument.text);
+
+        if (files.size() != 2){
+            std::cerr << "Expected an input file and a settings file" << std::endl;
+            return false;
+        }
+
+        options.input = cwd.getChildFile(files[0]);
+        options.settings = cwd.getChildFile(files[1]);
+        for (const auto& file : { options.input, options.settings }){
+            if (!file.existsAsFile()){
+                std::cerr << "No such file: " << file.getFullPathName() << std::endl;
+                return false;
+            }
+        }
+
+        options.output = value("--output").isNotEmpty() ? cwd.getChildFile(value("--output"))
+                                                        : options.input.getSiblingFile(options.input.getFileNameWithoutExtension() + "-sweep");
+        if (value("--block-size").isNotEmpty())
+            options.blockSize = juce::jlimit(64, 1 << 20, value("--block-size").getIntValue());
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h")){
+        std::cout << usage;
+        return 0;
+    }
+
+    Options options;
+    if (!parseOptions(args, options)){
+        std::cerr << usage;
+        return 1;
+    }
+
+    juce::var json;
+    const auto parsed = juce::JSON::parse(options.settings.loadFileAsString(), json);
+    if (parsed.failed() || !json.isArray()){
+        std::cerr << options.settings.getFullPathName() << ": "
+                  << (parsed.failed() ? parsed.getErrorMessage() : juce::String("expected an array of settings")) << std::endl;
+        return 1;
+    }
+
+    const auto settings = ParameterSweep::parseSettings(json);
+    std::cout << "Rendering " << options.input.getFileName() << " through " << (int)settings.size()
+              << " settings into " << options.output.getFullPathName() << std::endl;
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    const auto error = ParameterSweep::render(options.input, settings, options.output, options.blockSize);
+    if (error.isNotEmpty()){
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << (int)settings.size() << " files in "
+              << juce::String((juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0, 2) << " s" << std::endl;
+    return 0;
+}